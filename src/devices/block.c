@@ -125,6 +125,31 @@ block_read (struct block *block, block_sector_t sector, void *buffer)
   block->read_cnt++;
 }
 
+/* Reads CNT consecutive sectors from BLOCK starting at SECTOR.
+   Sector I goes to BUFFERS[I], which must have room for
+   BLOCK_SECTOR_SIZE bytes.  If the driver supports it, the whole
+   run comes from the device as a single request; otherwise each
+   sector is read in turn.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void
+block_read_multiple (struct block *block, block_sector_t sector,
+                     size_t cnt, void *const buffers[])
+{
+  size_t i;
+
+  if (cnt == 0)
+    return;
+  check_sector (block, sector);
+  check_sector (block, sector + cnt - 1);
+  if (block->ops->read_multiple != NULL)
+    block->ops->read_multiple (block->aux, sector, cnt, buffers);
+  else
+    for (i = 0; i < cnt; i++)
+      block->ops->read (block->aux, sector + i, buffers[i]);
+  block->read_cnt += cnt;
+}
+
 /* Write sector SECTOR to BLOCK from BUFFER, which must contain
    BLOCK_SECTOR_SIZE bytes.  Returns after the block device has
    acknowledged receiving the data.
@@ -139,6 +164,33 @@ block_write (struct block *block, block_sector_t sector, const void *buffer)
   block->write_cnt++;
 }
 
+/* Writes CNT consecutive sectors to BLOCK starting at SECTOR.
+   Sector I is taken from BUFFERS[I], which must contain
+   BLOCK_SECTOR_SIZE bytes.  If the driver supports it, the whole
+   run goes to the device as a single request; otherwise each
+   sector is written in turn.  Returns after the block device has
+   acknowledged receiving all of the data.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void
+block_write_multiple (struct block *block, block_sector_t sector,
+                      size_t cnt, const void *const buffers[])
+{
+  size_t i;
+
+  if (cnt == 0)
+    return;
+  check_sector (block, sector);
+  check_sector (block, sector + cnt - 1);
+  ASSERT (block->type != BLOCK_FOREIGN);
+  if (block->ops->write_multiple != NULL)
+    block->ops->write_multiple (block->aux, sector, cnt, buffers);
+  else
+    for (i = 0; i < cnt; i++)
+      block->ops->write (block->aux, sector + i, buffers[i]);
+  block->write_cnt += cnt;
+}
+
 /* Returns the number of sectors in BLOCK. */
 block_sector_t
 block_size (struct block *block)
@@ -41,6 +41,47 @@ input_getc (void)
   return key;
 }
 
+/* Reads SIZE keys from the input buffer into BUF, waiting for
+   keys only while the buffer is empty.  Every key that is
+   available is taken at once, so that interrupts are turned off
+   once per batch instead of once per key.  If LINE is true,
+   returns early after a new-line, and whatever LINE is, returns
+   early if input_wake() is called while it waits.  BUF must be
+   accessible without a page fault.  Returns the number of keys
+   read. */
+size_t
+input_read (uint8_t *buf, size_t size, bool line) 
+{
+  enum intr_level old_level;
+  size_t cnt = 0;
+
+  old_level = intr_disable ();
+  while (cnt < size)
+    {
+      size_t n = intq_getbuf (&buffer, buf + cnt, size - cnt,
+                              line ? '\n' : -1);
+      if (n == 0)
+        break;
+      cnt += n;
+      serial_notify ();
+      if (line && buf[cnt - 1] == '\n')
+        break;
+    }
+  intr_set_level (old_level);
+
+  return cnt;
+}
+
+/* Makes every thread waiting in input_read() return the keys it
+   has read so far. */
+void
+input_wake (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  intq_wake (&buffer);
+  intr_set_level (old_level);
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
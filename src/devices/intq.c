@@ -13,6 +13,7 @@ intq_init (struct intq *q)
   lock_init (&q->lock);
   q->not_full = q->not_empty = NULL;
   q->head = q->tail = 0;
+  q->wake_cnt = 0;
 }
 
 /* Returns true if Q is empty, false otherwise. */
@@ -54,6 +55,46 @@ intq_getc (struct intq *q)
   return byte;
 }
 
+/* Removes up to SIZE bytes from Q into BUF and returns the
+   number removed.  If Q is empty, sleeps until a byte is added,
+   then takes every byte that is available without sleeping
+   again, stopping early after a byte equal to STOP unless STOP
+   is negative.  Returns 0 without waiting any longer if
+   intq_wake() is called while Q is empty.  BUF must be
+   accessible without a page fault, since interrupts are off.
+   Must not be called from an interrupt handler. */
+size_t
+intq_getbuf (struct intq *q, uint8_t *buf, size_t size, int stop) 
+{
+  unsigned wake_cnt = q->wake_cnt;
+  size_t cnt = 0;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!intr_context ());
+  if (size == 0)
+    return 0;
+  while (intq_empty (q)) 
+    {
+      if (q->wake_cnt != wake_cnt)
+        return 0;
+      lock_acquire (&q->lock);
+      if (intq_empty (q) && q->wake_cnt == wake_cnt)
+        wait (q, &q->not_empty);
+      lock_release (&q->lock);
+    }
+
+  while (cnt < size && !intq_empty (q))
+    {
+      uint8_t byte = q->buf[q->tail];
+      q->tail = next (q->tail);
+      buf[cnt++] = byte;
+      if (byte == stop)
+        break;
+    }
+  signal (q, &q->not_full);
+  return cnt;
+}
+
 /* Adds BYTE to the end of Q.
    If Q is full, sleeps until a byte is removed.
    When called from an interrupt handler, Q must not be full. */
@@ -74,6 +115,22 @@ intq_putc (struct intq *q, uint8_t byte)
   signal (q, &q->not_empty);
 }
 
+/* Makes every thread in intq_getbuf() on Q, whether waiting for
+   a byte or for its turn to wait, return 0 if Q is still empty.
+   Interrupts must be off. */
+void
+intq_wake (struct intq *q) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  q->wake_cnt++;
+  if (q->not_empty != NULL) 
+    {
+      thread_unblock (q->not_empty);
+      q->not_empty = NULL;
+    }
+}
+
 /* Returns the position after POS within an intq. */
 static int
 next (int pos) 
@@ -17,8 +17,9 @@
    protect kernel threads from one another, not from interrupt
    handlers. */
 
-/* Queue buffer size, in bytes. */
-#define INTQ_BUFSIZE 64
+/* Queue buffer size, in bytes.  Large enough that console
+   output seldom has to wait for the serial port. */
+#define INTQ_BUFSIZE 1024
 
 /* A circular queue of bytes. */
 struct intq
@@ -27,6 +28,7 @@ struct intq
     struct lock lock;           /* Only one thread may wait at once. */
     struct thread *not_full;    /* Thread waiting for not-full condition. */
     struct thread *not_empty;   /* Thread waiting for not-empty condition. */
+    unsigned wake_cnt;          /* Number of calls to intq_wake(). */
 
     /* Queue. */
     uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
@@ -38,6 +40,8 @@ void intq_init (struct intq *);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
+size_t intq_getbuf (struct intq *, uint8_t *buf, size_t size, int stop);
 void intq_putc (struct intq *, uint8_t);
+void intq_wake (struct intq *);
 
 #endif /* devices/intq.h */
@@ -317,8 +317,30 @@ partition_write (void *p_, block_sector_t sector, const void *buffer)
   block_write (p->block, p->start + sector, buffer);
 }
 
+/* Writes CNT consecutive sectors to partition P starting at
+   SECTOR, sector I coming from BUFFERS[I]. */
+static void
+partition_write_multiple (void *p_, block_sector_t sector, size_t cnt,
+                          const void *const buffers[])
+{
+  struct partition *p = p_;
+  block_write_multiple (p->block, p->start + sector, cnt, buffers);
+}
+
+/* Reads CNT consecutive sectors from partition P starting at
+   SECTOR, sector I going to BUFFERS[I]. */
+static void
+partition_read_multiple (void *p_, block_sector_t sector, size_t cnt,
+                         void *const buffers[])
+{
+  struct partition *p = p_;
+  block_read_multiple (p->block, p->start + sector, cnt, buffers);
+}
+
 static struct block_operations partition_operations =
   {
     partition_read,
-    partition_write
+    partition_write,
+    partition_write_multiple,
+    partition_read_multiple
   };
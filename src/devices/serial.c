@@ -1,5 +1,6 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <stdio.h>
 #include "devices/input.h"
 #include "devices/intq.h"
 #include "devices/timer.h"
@@ -33,6 +34,17 @@
 #define MCR_REG (IO_BASE + 4)   /* MODEM Control Register. */
 #define LSR_REG (IO_BASE + 5)   /* Line Status Register (read-only). */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable the FIFOs. */
+#define FCR_CLEAR 0x06          /* Clear both FIFOs. */
+#define FCR_TRIGGER_14 0xc0     /* Receive interrupt at 14 bytes. */
+
+/* Interrupt Identification Register bits. */
+#define IIR_FIFO 0xc0           /* FIFOs enabled and working. */
+
+/* Size of the 16550A's transmit FIFO, in bytes. */
+#define TX_FIFO_SIZE 16
+
 /* Interrupt Enable Register bits. */
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
@@ -51,10 +63,27 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
+/* Data to be transmitted.  The transmit interrupt refills the
+   UART's FIFO from here, up to tx_burst bytes at a time. */
 static struct intq txq;
 
+/* Number of bytes that may be written to the UART each time it
+   reports its transmitter empty: TX_FIFO_SIZE if it has working
+   FIFOs (a 16550A), otherwise 1 (an 8250, 16450 or 16550). */
+static int tx_burst;
+
+/* Number of bytes putc_poll() may still write before it has to
+   wait for the transmitter to empty again. */
+static int tx_room;
+
+/* Statistics. */
+static long long rx_intr_cnt;   /* Interrupts that received data. */
+static long long rx_byte_cnt;   /* Bytes received. */
+static long long tx_intr_cnt;   /* Interrupts that transmitted data. */
+static long long tx_byte_cnt;   /* Bytes transmitted. */
+
 static void set_serial (int bps);
+static void init_fifo (void);
 static void putc_poll (uint8_t);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
@@ -68,7 +97,7 @@ init_poll (void)
 {
   ASSERT (mode == UNINIT);
   outb (IER_REG, 0);                    /* Turn off all interrupts. */
-  outb (FCR_REG, 0);                    /* Disable FIFO. */
+  init_fifo ();                         /* Enable FIFOs if present. */
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
   intq_init (&txq);
@@ -129,6 +158,45 @@ serial_putc (uint8_t byte)
   intr_set_level (old_level);
 }
 
+/* Sends the N bytes in BUF to the serial port.  Equivalent to
+   calling serial_putc() for each byte, but interrupts are turned
+   off and the interrupt enable register is updated once for the
+   whole buffer, except when the transmit queue fills up. */
+void
+serial_putbuf (const uint8_t *buf, size_t n) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (mode != QUEUE)
+    {
+      if (mode == UNINIT)
+        init_poll ();
+      while (n-- > 0)
+        putc_poll (*buf++);
+    }
+  else
+    {
+      for (; n > 0; n--)
+        {
+          if (intq_full (&txq))
+            {
+              /* As in serial_putc(), poll a byte out if we may
+                 not sleep.  Otherwise, make sure the transmit
+                 interrupt is on to empty the queue while we
+                 wait in intq_putc(). */
+              if (old_level == INTR_OFF)
+                putc_poll (intq_getc (&txq));
+              else
+                write_ier ();
+            }
+          intq_putc (&txq, *buf++);
+        }
+      write_ier ();
+    }
+
+  intr_set_level (old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void
@@ -152,6 +220,34 @@ serial_notify (void)
     write_ier ();
 }
 
+/* Prints serial port statistics. */
+void
+serial_print_stats (void) 
+{
+  printf ("Serial: %lld receive interrupts for %lld bytes, "
+          "%lld transmit interrupts for %lld bytes, %s\n",
+          rx_intr_cnt, rx_byte_cnt, tx_intr_cnt, tx_byte_cnt,
+          tx_burst > 1 ? "FIFOs enabled" : "no FIFOs");
+}
+
+/* Enables the UART's FIFOs, if it has working ones, with a
+   receive interrupt only once 14 bytes have arrived (or the line
+   has gone quiet), and sets tx_burst to match. */
+static void
+init_fifo (void)
+{
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR | FCR_TRIGGER_14);
+  if ((inb (IIR_REG) & IIR_FIFO) == IIR_FIFO)
+    tx_burst = TX_FIFO_SIZE;
+  else
+    {
+      /* No FIFOs, or the 16550's broken ones. */
+      outb (FCR_REG, 0);
+      tx_burst = 1;
+    }
+  tx_room = 0;
+}
+
 /* Configures the serial port for BPS bits per second. */
 static void
 set_serial (int bps)
@@ -194,34 +290,56 @@ write_ier (void)
 }
 
 /* Polls the serial port until it's ready,
-   and then transmits BYTE. */
+   and then transmits BYTE.  Once the transmitter is empty, the
+   next tx_burst bytes go straight into its FIFO without polling
+   again. */
 static void
 putc_poll (uint8_t byte) 
 {
   ASSERT (intr_get_level () == INTR_OFF);
 
-  while ((inb (LSR_REG) & LSR_THRE) == 0)
-    continue;
+  if (tx_room == 0)
+    {
+      while ((inb (LSR_REG) & LSR_THRE) == 0)
+        continue;
+      tx_room = tx_burst;
+    }
   outb (THR_REG, byte);
+  tx_room--;
 }
 
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) 
 {
+  int cnt;
+
   /* Inquire about interrupt in UART.  Without this, we can
      occasionally miss an interrupt running under QEMU. */
   inb (IIR_REG);
 
   /* As long as we have room to receive a byte, and the hardware
      has a byte for us, receive a byte.  */
-  while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
+  for (cnt = 0; !input_full () && (inb (LSR_REG) & LSR_DR) != 0; cnt++)
     input_putc (inb (RBR_REG));
+  if (cnt > 0)
+    {
+      rx_intr_cnt++;
+      rx_byte_cnt += cnt;
+    }
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* If the transmitter is empty, refill it from the queue. */
+  if ((inb (LSR_REG) & LSR_THRE) != 0)
+    {
+      for (cnt = 0; cnt < tx_burst && !intq_empty (&txq); cnt++)
+        outb (THR_REG, intq_getc (&txq));
+      if (cnt > 0)
+        {
+          tx_intr_cnt++;
+          tx_byte_cnt += cnt;
+          tx_room = 0;
+        }
+    }
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
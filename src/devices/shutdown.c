@@ -5,13 +5,21 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "threads/io.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
+#include "userprog/syscall.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
+#endif
+#ifdef VM
+#include "vm/swap.h"
 #endif
 
 /* Keyboard control register port. */
@@ -132,12 +140,21 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  palloc_print_stats ();
+  malloc_print_stats ();
+  slab_print_stats ();
 #ifdef FILESYS
   block_print_stats ();
+  inode_print_stats ();
 #endif
   console_print_stats ();
   kbd_print_stats ();
+  serial_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  syscall_print_stats ();
+#endif
+#ifdef VM
+  swap_print_stats ();
 #endif
 }
@@ -1,4 +1,5 @@
 #include "devices/vga.h"
+#include <debug.h>
 #include <round.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -22,13 +23,22 @@ static size_t cx, cy;
 #define GRAY_ON_BLACK 0x07
 
 /* Framebuffer.  See [FREEVGA] under "VGA Text Mode Operation".
-   The character at (x,y) is fb[y][x][0].
-   The attribute at (x,y) is fb[y][x][1]. */
+   The character at (x,y) is row(y)[x][0].
+   The attribute at (x,y) is row(y)[x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+/* Framebuffer row that holds screen row 0.  Scrolling just
+   advances this, treating the framebuffer as a ring of rows, and
+   flush_scroll() moves the rows back into place once output is
+   done, so that a batch of output scrolls the screen once no
+   matter how many lines it adds.  Always 0 between calls. */
+static size_t top;
+
+static void putc_locked (int c, enum intr_level old_level);
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
+static void flush_scroll (void);
 static void move_cursor (void);
 static void find_cursor (size_t *x, size_t *y);
 
@@ -46,6 +56,12 @@ init (void)
     }
 }
 
+/* Returns screen row Y of the framebuffer. */
+static inline uint8_t (*row (size_t y))[2]
+{
+  return fb[(top + y) % ROW_CNT];
+}
+
 /* Writes C to the VGA text display, interpreting control
    characters in the conventional ways.  */
 void
@@ -56,7 +72,41 @@ vga_putc (int c)
   enum intr_level old_level = intr_disable ();
 
   init ();
-  
+  putc_locked (c, old_level);
+  flush_scroll ();
+
+  /* Update cursor position. */
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Writes the N characters in BUF to the VGA text display, as
+   vga_putc() would, but scrolling the screen and moving the
+   hardware cursor only once for the whole buffer. */
+void
+vga_putbuf (const char *buf, size_t n)
+{
+  enum intr_level old_level = intr_disable ();
+
+  init ();
+  while (n-- > 0)
+    putc_locked (*buf++, old_level);
+  flush_scroll ();
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Writes C to the VGA text display, interpreting control
+   characters in the conventional ways.  Interrupts must be off;
+   OLD_LEVEL is the level to restore while beeping.  Leaves
+   scrolling and the hardware cursor to the caller. */
+static void
+putc_locked (int c, enum intr_level old_level)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
   switch (c) 
     {
     case '\n':
@@ -89,30 +139,25 @@ vga_putc (int c)
       break;
       
     default:
-      fb[cy][cx][0] = c;
-      fb[cy][cx][1] = GRAY_ON_BLACK;
+      row (cy)[cx][0] = c;
+      row (cy)[cx][1] = GRAY_ON_BLACK;
       if (++cx >= COL_CNT)
         newline ();
       break;
     }
-
-  /* Update cursor position. */
-  move_cursor ();
-
-  intr_set_level (old_level);
 }
-
+
 /* Clears the screen and moves the cursor to the upper left. */
 static void
 cls (void)
 {
   size_t y;
 
+  top = 0;
   for (y = 0; y < ROW_CNT; y++)
     clear_row (y);
 
   cx = cy = 0;
-  move_cursor ();
 }
 
 /* Clears row Y to spaces. */
@@ -123,8 +168,8 @@ clear_row (size_t y)
 
   for (x = 0; x < COL_CNT; x++)
     {
-      fb[y][x][0] = ' ';
-      fb[y][x][1] = GRAY_ON_BLACK;
+      row (y)[x][0] = ' ';
+      row (y)[x][1] = GRAY_ON_BLACK;
     }
 }
 
@@ -139,11 +184,27 @@ newline (void)
   if (cy >= ROW_CNT)
     {
       cy = ROW_CNT - 1;
-      memmove (&fb[0], &fb[1], sizeof fb[0] * (ROW_CNT - 1));
+      top = (top + 1) % ROW_CNT;
       clear_row (ROW_CNT - 1);
     }
 }
 
+/* Moves the rows of the framebuffer so that screen row 0 is at
+   the top again, completing any scrolling done since the last
+   call. */
+static void
+flush_scroll (void)
+{
+  static uint8_t save[ROW_CNT][COL_CNT][2];
+
+  if (top == 0)
+    return;
+  memcpy (save, fb, sizeof fb[0] * top);
+  memmove (&fb[0], &fb[top], sizeof fb[0] * (ROW_CNT - top));
+  memcpy (&fb[ROW_CNT - top], save, sizeof fb[0] * top);
+  top = 0;
+}
+
 /* Moves the hardware cursor to (cx,cy). */
 static void
 move_cursor (void) 
@@ -5,6 +5,7 @@
 
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
+static void run_pipeline (char *left, char *right);
 
 int
 main (void)
@@ -13,6 +14,7 @@ main (void)
   for (;;) 
     {
       char command[80];
+      char *bar;
 
       /* Read command. */
       printf ("--");
@@ -30,6 +32,11 @@ main (void)
         {
           /* Empty command. */
         }
+      else if ((bar = strchr (command, '|')) != NULL)
+        {
+          *bar = '\0';
+          run_pipeline (command, bar + 1);
+        }
       else
         {
           pid_t pid = exec (command);
@@ -44,6 +51,52 @@ main (void)
   return EXIT_SUCCESS;
 }
 
+/* Runs commands LEFT and RIGHT together, with the standard output
+   of LEFT going through a pipe to the standard input of RIGHT,
+   and waits for both of them. */
+static void
+run_pipeline (char *left, char *right)
+{
+  pid_t left_pid, right_pid;
+  char *end;
+  int fds[2];
+
+  while (*left == ' ')
+    left++;
+  for (end = strchr (left, '\0'); end > left && end[-1] == ' '; )
+    *--end = '\0';
+  while (*right == ' ')
+    right++;
+  if (pipe (fds) < 0)
+    {
+      printf ("pipe failed\n");
+      return;
+    }
+
+  /* A child started by exec inherits our standard input and
+     output while they are redirected.  Closing them puts us
+     back on the console.  Each child gets only its own end of
+     the pipe, so RIGHT sees end of file once LEFT exits. */
+  dup2 (fds[1], STDOUT_FILENO);
+  close (fds[1]);
+  left_pid = exec (left);
+  close (STDOUT_FILENO);
+
+  dup2 (fds[0], STDIN_FILENO);
+  close (fds[0]);
+  right_pid = exec (right);
+  close (STDIN_FILENO);
+
+  if (left_pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", left, wait (left_pid));
+  else
+    printf ("exec failed\n");
+  if (right_pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", right, wait (right_pid));
+  else
+    printf ("exec failed\n");
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
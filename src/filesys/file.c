@@ -1,7 +1,7 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* An open file. */
 struct file 
@@ -9,26 +9,38 @@ struct file
     struct inode *inode;        /* File's inode. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
+    int open_cnt;               /* Number of openers sharing the file. */
   };
 
+/* Cache of `struct file's. */
+static struct slab_cache file_cache;
+
+/* Initializes the file module. */
+void
+file_init (void)
+{
+  slab_cache_init (&file_cache, "file", sizeof (struct file), NULL);
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
    and returns the new file.  Returns a null pointer if an
    allocation fails or if INODE is null. */
 struct file *
 file_open (struct inode *inode) 
 {
-  struct file *file = calloc (1, sizeof *file);
+  struct file *file = slab_alloc (&file_cache);
   if (inode != NULL && file != NULL)
     {
       file->inode = inode;
       file->pos = 0;
       file->deny_write = false;
+      file->open_cnt = 1;
       return file;
     }
   else
     {
       inode_close (inode);
-      free (file);
+      slab_free (&file_cache, file);
       return NULL; 
     }
 }
@@ -41,15 +53,26 @@ file_reopen (struct file *file)
   return file_open (inode_reopen (file->inode));
 }
 
-/* Closes FILE. */
+/* Adds an opener to FILE, which it then shares, position and
+   all, with the others until each has called file_close().
+   Returns FILE. */
+struct file *
+file_dup (struct file *file) 
+{
+  file->open_cnt++;
+  return file;
+}
+
+/* Closes FILE, unless it has other openers, in which case it
+   only drops this one. */
 void
 file_close (struct file *file) 
 {
-  if (file != NULL)
+  if (file != NULL && --file->open_cnt == 0)
     {
       file_allow_write (file);
       inode_close (file->inode);
-      free (file); 
+      slab_free (&file_cache, file); 
     }
 }
 
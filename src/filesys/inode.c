@@ -1,15 +1,29 @@
 #include "filesys/inode.h"
 #include <list.h>
 #include <debug.h>
+#include <inttypes.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Maximum number of whole sectors that inode_read_at() and
+   inode_write_at() move in one block device request. */
+#define SECTOR_RUN 32
+
+/* Reads of at least this many bytes count toward the large-read
+   statistics. */
+#define LARGE_READ (SECTOR_RUN * BLOCK_SECTOR_SIZE)
+
 /* On-disk inode.
    Must be exactly BLOCK_SECTOR_SIZE bytes long. */
 struct inode_disk
@@ -57,11 +71,42 @@ byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of `struct inode's. */
+static struct slab_cache inode_cache;
+
+/* Holds the sector at an unaligned start or end of a read or
+   write.  Whole sectors move directly between the disk and the
+   caller's buffer, which for a system call is the user's own
+   buffer, pinned in memory for the duration. */
+static uint8_t bounce[BLOCK_SECTOR_SIZE];
+static struct lock bounce_lock;
+
+/* Number of large reads, the bytes they returned and the timer
+   ticks they took.  Updated with interrupts off. */
+static long long large_read_cnt;
+static long long large_read_bytes;
+static int64_t large_read_ticks;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  slab_cache_init (&inode_cache, "inode", sizeof (struct inode), NULL);
+  lock_init (&bounce_lock);
+}
+
+/* Returns the number of whole sectors, at most SECTOR_RUN, in a
+   transfer of SIZE bytes to or from INODE starting at OFFSET,
+   which must be sector-aligned. */
+static size_t
+sector_run (const struct inode *inode, off_t size, off_t offset)
+{
+  off_t inode_left = inode_length (inode) - offset;
+  off_t left = size < inode_left ? size : inode_left;
+  size_t cnt = left / BLOCK_SECTOR_SIZE;
+
+  return cnt < SECTOR_RUN ? cnt : SECTOR_RUN;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -127,7 +172,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = slab_alloc (&inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -181,7 +226,7 @@ inode_close (struct inode *inode)
                             bytes_to_sectors (inode->data.length)); 
         }
 
-      free (inode); 
+      slab_free (&inode_cache, inode); 
     }
 }
 
@@ -202,7 +247,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
 {
   uint8_t *buffer = buffer_;
   off_t bytes_read = 0;
-  uint8_t *bounce = NULL;
+  int64_t start = timer_ticks ();
+  enum intr_level old_level;
 
   while (size > 0) 
     {
@@ -222,21 +268,25 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
 
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
-          /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
+          /* Read a run of full sectors directly into caller's
+             buffer. */
+          void *buffers[SECTOR_RUN];
+          size_t cnt = sector_run (inode, size, offset);
+          size_t i;
+
+          for (i = 0; i < cnt; i++)
+            buffers[i] = buffer + bytes_read + i * BLOCK_SECTOR_SIZE;
+          block_read_multiple (fs_device, sector_idx, cnt, buffers);
+          chunk_size = cnt * BLOCK_SECTOR_SIZE;
         }
       else 
         {
           /* Read sector into bounce buffer, then partially copy
              into caller's buffer. */
-          if (bounce == NULL) 
-            {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
-              if (bounce == NULL)
-                break;
-            }
+          lock_acquire (&bounce_lock);
           block_read (fs_device, sector_idx, bounce);
           memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+          lock_release (&bounce_lock);
         }
       
       /* Advance. */
@@ -244,7 +294,15 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       offset += chunk_size;
       bytes_read += chunk_size;
     }
-  free (bounce);
+
+  if (bytes_read >= LARGE_READ)
+    {
+      old_level = intr_disable ();
+      large_read_cnt++;
+      large_read_bytes += bytes_read;
+      large_read_ticks += timer_elapsed (start);
+      intr_set_level (old_level);
+    }
 
   return bytes_read;
 }
@@ -260,7 +318,6 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 {
   const uint8_t *buffer = buffer_;
   off_t bytes_written = 0;
-  uint8_t *bounce = NULL;
 
   if (inode->deny_write_cnt)
     return 0;
@@ -283,18 +340,19 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
-          /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
+          /* Write a run of full sectors directly to disk. */
+          const void *buffers[SECTOR_RUN];
+          size_t cnt = sector_run (inode, size, offset);
+          size_t i;
+
+          for (i = 0; i < cnt; i++)
+            buffers[i] = buffer + bytes_written + i * BLOCK_SECTOR_SIZE;
+          block_write_multiple (fs_device, sector_idx, cnt, buffers);
+          chunk_size = cnt * BLOCK_SECTOR_SIZE;
         }
       else 
         {
-          /* We need a bounce buffer. */
-          if (bounce == NULL) 
-            {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
-              if (bounce == NULL)
-                break;
-            }
+          lock_acquire (&bounce_lock);
 
           /* If the sector contains data before or after the chunk
              we're writing, then we need to read in the sector
@@ -305,6 +363,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
             memset (bounce, 0, BLOCK_SECTOR_SIZE);
           memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
           block_write (fs_device, sector_idx, bounce);
+          lock_release (&bounce_lock);
         }
 
       /* Advance. */
@@ -312,7 +371,6 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       offset += chunk_size;
       bytes_written += chunk_size;
     }
-  free (bounce);
 
   return bytes_written;
 }
@@ -343,3 +401,14 @@ inode_length (const struct inode *inode)
 {
   return inode->data.length;
 }
+
+/* Prints statistics about large reads. */
+void
+inode_print_stats (void)
+{
+  printf ("Large reads: %lld reads, %lld bytes in %"PRId64" ticks",
+          large_read_cnt, large_read_bytes, large_read_ticks);
+  if (large_read_ticks > 0)
+    printf (" (%lld bytes/tick)", large_read_bytes / large_read_ticks);
+  printf ("\n");
+}
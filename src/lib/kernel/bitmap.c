@@ -245,21 +245,48 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
   return value_cnt;
 }
 
+/* Returns the index of the first bit in B between START and
+   END, exclusive, that is set to VALUE, or END if there is none.
+   Examines a whole element at a time, using the processor's
+   bit-scan instruction to find the bit within it. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, size_t end, bool value)
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t idx, last_idx;
+  elem_type e;
+
+  ASSERT (end <= b->bit_cnt);
+
+  if (start >= end)
+    return end;
+
+  /* Set bits in E mark bits equal to VALUE, ignoring those
+     before START. */
+  idx = elem_idx (start);
+  last_idx = elem_idx (end - 1);
+  e = (b->bits[idx] ^ flip) & ~(bit_mask (start) - 1);
+  while (e == 0)
+    {
+      if (++idx > last_idx)
+        return end;
+      e = b->bits[idx] ^ flip;
+    }
+
+  start = idx * ELEM_BITS + __builtin_ctzl (e);
+  return start < end ? start : end;
+}
+
 /* Returns true if any bits in B between START and START + CNT,
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_bit (b, start, start + cnt, value) != start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -301,10 +328,25 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+
+      if (cnt == 0)
+        return start;
+
+      /* Jump to the next bit set to VALUE, then past the run of
+         such bits that it begins, until a run is long enough. */
+      while (i <= last)
+        {
+          size_t run_end;
+
+          i = find_bit (b, i, b->bit_cnt, value);
+          if (i > last)
+            break;
+          run_end = find_bit (b, i, i + cnt, !value);
+          if (run_end == i + cnt)
+            return i;
+          i = run_end;
+        }
     }
   return BITMAP_ERROR;
 }
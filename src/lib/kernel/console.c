@@ -1,6 +1,7 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
@@ -9,6 +10,17 @@
 
 static void vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
+static void putbuf_have_lock (const char *, size_t n);
+
+/* Output of one vprintf() call, gathered so that it reaches the
+   serial and VGA layers in chunks rather than a character at a
+   time. */
+struct vprintf_buffer
+  {
+    char buf[64];               /* Characters not yet written. */
+    size_t cnt;                 /* Number of characters in BUF. */
+    int char_cnt;               /* Total characters output. */
+  };
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -125,13 +137,16 @@ console_locked_by_current_thread (void)
 int
 vprintf (const char *format, va_list args) 
 {
-  int char_cnt = 0;
+  struct vprintf_buffer b;
 
+  b.cnt = 0;
+  b.char_cnt = 0;
   acquire_console ();
-  __vprintf (format, args, vprintf_helper, &char_cnt);
+  __vprintf (format, args, vprintf_helper, &b);
+  putbuf_have_lock (b.buf, b.cnt);
   release_console ();
 
-  return char_cnt;
+  return b.char_cnt;
 }
 
 /* Writes string S to the console, followed by a new-line
@@ -140,8 +155,7 @@ int
 puts (const char *s) 
 {
   acquire_console ();
-  while (*s != '\0')
-    putchar_have_lock (*s++);
+  putbuf_have_lock (s, strlen (s));
   putchar_have_lock ('\n');
   release_console ();
 
@@ -153,8 +167,7 @@ void
 putbuf (const char *buffer, size_t n) 
 {
   acquire_console ();
-  while (n-- > 0)
-    putchar_have_lock (*buffer++);
+  putbuf_have_lock (buffer, n);
   release_console ();
 }
 
@@ -171,11 +184,17 @@ putchar (int c)
 
 /* Helper function for vprintf(). */
 static void
-vprintf_helper (char c, void *char_cnt_) 
+vprintf_helper (char c, void *b_) 
 {
-  int *char_cnt = char_cnt_;
-  (*char_cnt)++;
-  putchar_have_lock (c);
+  struct vprintf_buffer *b = b_;
+
+  b->char_cnt++;
+  if (b->cnt >= sizeof b->buf)
+    {
+      putbuf_have_lock (b->buf, b->cnt);
+      b->cnt = 0;
+    }
+  b->buf[b->cnt++] = c;
 }
 
 /* Writes C to the vga display and serial port.
@@ -189,3 +208,15 @@ putchar_have_lock (uint8_t c)
   serial_putc (c);
   vga_putc (c);
 }
+
+/* Writes the N characters in BUF to the vga display and serial
+   port, each as a single batch.  The caller has already acquired
+   the console lock if appropriate. */
+static void
+putbuf_have_lock (const char *buf, size_t n) 
+{
+  ASSERT (console_locked_by_current_thread ());
+  write_cnt += n;
+  serial_putbuf ((const uint8_t *) buf, n);
+  vga_putbuf (buf, n);
+}
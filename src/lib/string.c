@@ -1,5 +1,41 @@
 #include <string.h>
 #include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The block operations below move and compare 32-bit words at a
+   time.  Each handles the bytes before the first aligned word of
+   the destination and after the last one separately, so that the
+   word accesses to it are aligned; x86 permits the other operand
+   to be unaligned.  WORD is a 32-bit type that may alias
+   anything, so that the compiler does not assume that word and
+   byte accesses to the same memory are unrelated. */
+typedef uint32_t __attribute__ ((may_alias)) word;
+
+/* Blocks shorter than this are handled a byte at a time, since
+   aligning them costs more than it saves. */
+#define WORD_MIN 16
+
+/* Copies SIZE bytes from SRC to DST, from the lowest address
+   upward.  Correct if DST and SRC do not overlap or if DST is
+   below SRC. */
+static inline void
+copy_up (unsigned char *dst, const unsigned char *src, size_t size)
+{
+  if (size >= WORD_MIN)
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words = (size - head) / 4;
+
+      size = (size - head) & 3;
+      asm volatile ("rep movsb"
+                    : "+D" (dst), "+S" (src), "+c" (head) : : "memory");
+      asm volatile ("rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+    }
+  asm volatile ("rep movsb"
+                : "+D" (dst), "+S" (src), "+c" (size) : : "memory");
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,9 +48,7 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
-
+  copy_up (dst, src, size);
   return dst_;
 }
 
@@ -29,20 +63,30 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
+  if (dst <= src) 
+    copy_up (dst, src, size);
   else 
     {
+      /* Copy from the top down, so that each byte of SRC is read
+         before the copy can overwrite it. */
       dst += size;
       src += size;
+      if (size >= WORD_MIN)
+        {
+          for (; ((uintptr_t) dst & 3) != 0; size--)
+            *--dst = *--src;
+          for (; size >= 4; size -= 4)
+            {
+              dst -= 4;
+              src -= 4;
+              *(word *) dst = *(const word *) src;
+            }
+        }
       while (size-- > 0)
         *--dst = *--src;
     }
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +102,18 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words.  The first difference, if any, is
+     then found in the byte loop. */
+  if (size >= WORD_MIN)
+    {
+      for (; ((uintptr_t) a & 3) != 0; a++, b++, size--)
+        if (*a != *b)
+          return *a > *b ? +1 : -1;
+      for (; size >= 4; a += 4, b += 4, size -= 4)
+        if (*(const word *) a != *(const word *) b)
+          break;
+    }
+
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -279,15 +335,35 @@ void *
 memset (void *dst_, int value, size_t size) 
 {
   unsigned char *dst = dst_;
+  uint8_t byte = value;
 
   ASSERT (dst != NULL || size == 0);
-  
-  while (size-- > 0)
-    *dst++ = value;
+
+  if (size >= WORD_MIN)
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words = (size - head) / 4;
+
+      size = (size - head) & 3;
+      asm volatile ("rep stosb"
+                    : "+D" (dst), "+c" (head) : "a" (byte) : "memory");
+      asm volatile ("rep stosl"
+                    : "+D" (dst), "+c" (words)
+                    : "a" (byte * 0x01010101u) : "memory");
+    }
+  asm volatile ("rep stosb"
+                : "+D" (dst), "+c" (size) : "a" (byte) : "memory");
 
   return dst_;
 }
 
+/* Returns true if any byte of W is zero. */
+static inline bool
+word_has_zero (uint32_t w)
+{
+  return ((w - 0x01010101u) & ~w & 0x80808080u) != 0;
+}
+
 /* Returns the length of STRING. */
 size_t
 strlen (const char *string) 
@@ -296,7 +372,16 @@ strlen (const char *string)
 
   ASSERT (string != NULL);
 
-  for (p = string; *p != '\0'; p++)
+  /* Check bytes up to a word boundary, then whole words until
+     one contains a null byte.  An aligned word never straddles
+     a page boundary, so reading past the null is harmless. */
+  for (p = string; ((uintptr_t) p & 3) != 0; p++)
+    if (*p == '\0')
+      return p - string;
+  while (!word_has_zero (*(const word *) p))
+    p += 4;
+
+  for (; *p != '\0'; p++)
     continue;
   return p - string;
 }
@@ -28,7 +28,21 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_FORK,                   /* Duplicate this process. */
+    SYS_PREAD,                  /* Read from a position in a file. */
+    SYS_PWRITE,                 /* Write to a position in a file. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Duplicate a file descriptor. */
+    SYS_FUTEX_WAIT,             /* Sleep on a word of user memory. */
+    SYS_FUTEX_WAKE,             /* Wake sleepers on a word. */
+    SYS_SPAWN_THREAD,           /* Start a thread in this process. */
+    SYS_JOIN_THREAD,            /* Wait for a thread to end. */
+    SYS_EXIT_THREAD             /* End this thread. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,16 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* A buffer for readv() and writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Length of buffer in bytes. */
+  };
+
+/* Maximum number of buffers in one readv() or writev() call. */
+#define IOV_MAX 1024
+
+#endif /* lib/uio.h */
@@ -3,11 +3,16 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -45,4 +50,18 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+pid_t fork (void);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pipe (int fds[2]);
+int dup2 (int oldfd, int newfd);
+int futex_wait (int *addr, int expected);
+int futex_wake (int *addr, int cnt);
+tid_t spawn_thread (void (*entry) (void *), void *arg, void *stack);
+int join_thread (tid_t);
+void exit_thread (void) NO_RETURN;
+
 #endif /* lib/user/syscall.h */
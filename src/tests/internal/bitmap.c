@@ -0,0 +1,87 @@
+/* Benchmark and test program for bitmap_scan() in
+   lib/kernel/bitmap.c.
+
+   Fills bitmaps to several densities, checks bitmap_scan()
+   against a bit-by-bit search for runs of various lengths, and
+   reports how long a batch of scans takes at each density.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+#include "devices/timer.h"
+
+/* Number of bits in each bitmap. */
+#define BIT_CNT 8192
+
+/* Number of scans timed for each density and run length. */
+#define SCAN_CNT 2000
+
+static size_t slow_scan (const struct bitmap *, size_t start, size_t cnt,
+                         bool value);
+
+/* Tests and times bitmap_scan(). */
+void
+test (void)
+{
+  static const int densities[] = {0, 1, 50, 99, 100};
+  static const size_t cnts[] = {1, 7, 32, 100};
+  struct bitmap *b = bitmap_create (BIT_CNT);
+  size_t i, j, k;
+
+  ASSERT (b != NULL);
+  for (i = 0; i < sizeof densities / sizeof *densities; i++)
+    {
+      /* Set about DENSITIES[I] percent of the bits. */
+      for (k = 0; k < BIT_CNT; k++)
+        bitmap_set (b, k, (int) (random_ulong () % 100) < densities[i]);
+
+      for (j = 0; j < sizeof cnts / sizeof *cnts; j++)
+        {
+          int64_t start;
+
+          /* Check against a bit-by-bit search from many starts. */
+          for (k = 0; k < 64; k++)
+            {
+              size_t ofs = random_ulong () % BIT_CNT;
+              ASSERT (bitmap_scan (b, ofs, cnts[j], false)
+                      == slow_scan (b, ofs, cnts[j], false));
+              ASSERT (bitmap_scan (b, ofs, cnts[j], true)
+                      == slow_scan (b, ofs, cnts[j], true));
+            }
+
+          start = timer_ticks ();
+          for (k = 0; k < SCAN_CNT; k++)
+            bitmap_scan (b, 0, cnts[j], false);
+          printf ("%3d%% set, run of %3zu clear bits: "
+                  "%d scans in %"PRId64" ticks\n",
+                  densities[i], cnts[j], SCAN_CNT, timer_elapsed (start));
+        }
+    }
+  bitmap_destroy (b);
+}
+
+/* Finds a run of CNT bits set to VALUE in B at or after START
+   by testing every candidate bit by bit, as a reference. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= bitmap_size (b); i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
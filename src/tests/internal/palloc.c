@@ -0,0 +1,99 @@
+/* Benchmark and test program for threads/palloc.c.
+
+   Allocates and frees runs of pages of random sizes in random
+   order, checking that no two live runs overlap, and reports how
+   long that took and how fragmented the pools are afterward.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/test.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+/* Number of runs of pages held at once. */
+#define RUN_CNT 64
+
+/* Largest run of pages requested, as a power of 2. */
+#define MAX_RUN_ORDER 4
+
+/* Number of allocate/free rounds. */
+#define ROUND_CNT 20000
+
+/* A run of pages. */
+struct run
+  {
+    uint8_t *pages;             /* First page, or null. */
+    size_t page_cnt;            /* Number of pages. */
+  };
+
+static void check_run (const struct run *, size_t idx);
+
+/* Benchmarks the page allocator. */
+void
+test (void)
+{
+  static struct run runs[RUN_CNT];
+  unsigned long long allocs = 0, failures = 0;
+  int64_t start;
+  size_t i;
+  int round;
+
+  printf ("testing palloc with %d rounds of up to %d-page runs:",
+          ROUND_CNT, 1 << MAX_RUN_ORDER);
+  start = timer_ticks ();
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      struct run *r = &runs[random_ulong () % RUN_CNT];
+
+      if (r->pages != NULL)
+        {
+          check_run (r, r - runs);
+          palloc_free_multiple (r->pages, r->page_cnt);
+          r->pages = NULL;
+        }
+      else
+        {
+          r->page_cnt = random_ulong () % (1 << MAX_RUN_ORDER) + 1;
+          r->pages = palloc_get_multiple (0, r->page_cnt);
+          allocs++;
+          if (r->pages != NULL)
+            memset (r->pages, r - runs, r->page_cnt * PGSIZE);
+          else
+            failures++;
+        }
+    }
+
+  for (i = 0; i < RUN_CNT; i++)
+    if (runs[i].pages != NULL)
+      {
+        check_run (&runs[i], i);
+        palloc_free_multiple (runs[i].pages, runs[i].page_cnt);
+        runs[i].pages = NULL;
+      }
+  printf (" done\n");
+
+  printf ("%llu allocations (%llu failed) in %"PRId64" ticks\n",
+          allocs, failures, timer_elapsed (start));
+  palloc_print_stats ();
+}
+
+/* Verifies that run R, which is runs[IDX], still holds the bytes
+   written when it was allocated, so that no other run has been
+   given any of its pages. */
+static void
+check_run (const struct run *r, size_t idx)
+{
+  size_t ofs;
+
+  for (ofs = 0; ofs < r->page_cnt * PGSIZE; ofs++)
+    ASSERT (r->pages[ofs] == (uint8_t) idx);
+}
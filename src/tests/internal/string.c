@@ -0,0 +1,165 @@
+/* Benchmark and test program for the block operations in
+   lib/string.c.
+
+   Checks memcpy(), memmove(), memset(), memcmp(), and strlen()
+   against simple byte loops at every combination of a few sizes
+   and alignments, then reports how many timer ticks each of
+   them takes to process 16 MB in blocks of each size.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+#include "devices/timer.h"
+
+/* Largest block that we test. */
+#define MAX_SIZE 4096
+
+/* Total number of bytes processed for each measurement. */
+#define BENCH_BYTES (16 * 1024 * 1024)
+
+/* Buffers, with room for misalignment and for memmove() to
+   overlap. */
+static uint8_t src_buf[MAX_SIZE * 2 + 8];
+static uint8_t dst_buf[MAX_SIZE * 2 + 8];
+
+static void verify (size_t size, size_t src_ofs, size_t dst_ofs);
+static void benchmark (size_t size, size_t ofs);
+
+/* Tests and times the string block operations. */
+void
+test (void)
+{
+  static const size_t sizes[] = {1, 15, 16, 17, 64, 255, 512, 4096};
+  size_t i, src_ofs, dst_ofs;
+
+  printf ("testing string operations:");
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    for (src_ofs = 0; src_ofs < 4; src_ofs++)
+      for (dst_ofs = 0; dst_ofs < 4; dst_ofs++)
+        verify (sizes[i], src_ofs, dst_ofs);
+  printf (" done\n");
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      benchmark (sizes[i], 0);
+      benchmark (sizes[i], 1);
+    }
+}
+
+/* Fills the first SIZE bytes of BUF with random bytes, none of
+   them zero. */
+static void
+fill_random (uint8_t *buf, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    buf[i] = random_ulong () % 255 + 1;
+}
+
+/* Checks each operation on SIZE bytes at offsets SRC_OFS and
+   DST_OFS into the source and destination buffers. */
+static void
+verify (size_t size, size_t src_ofs, size_t dst_ofs)
+{
+  static uint8_t expect[sizeof dst_buf];
+  uint8_t *src = src_buf + src_ofs;
+  uint8_t *dst = dst_buf + dst_ofs;
+  size_t i;
+
+  /* memcpy(). */
+  fill_random (src_buf, sizeof src_buf);
+  fill_random (dst_buf, sizeof dst_buf);
+  memcpy (expect, dst_buf, sizeof dst_buf);
+  for (i = 0; i < size; i++)
+    expect[dst_ofs + i] = src[i];
+  ASSERT (memcpy (dst, src, size) == dst);
+  for (i = 0; i < sizeof dst_buf; i++)
+    ASSERT (dst_buf[i] == expect[i]);
+
+  /* memcmp(), on equal blocks and then with one byte changed. */
+  ASSERT (memcmp (dst, src, size) == 0);
+  dst[size / 2]++;
+  ASSERT (memcmp (dst, src, size) != 0);
+  ASSERT ((memcmp (dst, src, size) > 0)
+          == (dst[size / 2] > src[size / 2]));
+
+  /* memmove(), overlapping in both directions. */
+  for (i = 0; i < 2; i++)
+    {
+      uint8_t *from = i == 0 ? dst_buf + src_ofs : dst_buf + dst_ofs + 3;
+      uint8_t *to = i == 0 ? dst_buf + dst_ofs + 3 : dst_buf + src_ofs;
+      size_t j;
+
+      fill_random (dst_buf, sizeof dst_buf);
+      memcpy (expect, dst_buf, sizeof dst_buf);
+      for (j = 0; j < size; j++)
+        src_buf[j] = from[j];
+      for (j = 0; j < size; j++)
+        expect[(to - dst_buf) + j] = src_buf[j];
+      ASSERT (memmove (to, from, size) == to);
+      for (j = 0; j < sizeof dst_buf; j++)
+        ASSERT (dst_buf[j] == expect[j]);
+    }
+
+  /* memset(). */
+  fill_random (dst_buf, sizeof dst_buf);
+  memcpy (expect, dst_buf, sizeof dst_buf);
+  for (i = 0; i < size; i++)
+    expect[dst_ofs + i] = 0xa5;
+  ASSERT (memset (dst, 0xa5, size) == dst);
+  for (i = 0; i < sizeof dst_buf; i++)
+    ASSERT (dst_buf[i] == expect[i]);
+
+  /* strlen(). */
+  fill_random (src_buf, sizeof src_buf);
+  src[size] = '\0';
+  ASSERT (strlen ((char *) src) == size);
+}
+
+/* Prints the throughput of each operation on SIZE-byte blocks
+   at offset OFS from word alignment. */
+static void
+benchmark (size_t size, size_t ofs)
+{
+  size_t iterations = BENCH_BYTES / size;
+  uint8_t *src = src_buf + ofs;
+  uint8_t *dst = dst_buf + ofs;
+  int64_t ticks[5];
+  int64_t start;
+  size_t i;
+  int k;
+
+  fill_random (src_buf, sizeof src_buf);
+  src[size] = '\0';
+  memcpy (dst, src, size + 1);
+
+  for (k = 0; k < 5; k++)
+    {
+      start = timer_ticks ();
+      for (i = 0; i < iterations; i++)
+        switch (k)
+          {
+          case 0: memcpy (dst, src, size); break;
+          case 1: memmove (dst + 1, dst, size); break;
+          case 2: memset (dst, i, size); break;
+          case 3: ASSERT (memcmp (dst, dst, size) == 0); break;
+          case 4: ASSERT (strlen ((char *) src) == size); break;
+          }
+      ticks[k] = timer_elapsed (start);
+    }
+
+  printf ("%4zu bytes, offset %zu: memcpy %"PRId64", memmove %"PRId64
+          ", memset %"PRId64", memcmp %"PRId64", strlen %"PRId64
+          " ticks per %d MB\n",
+          size, ofs, ticks[0], ticks[1], ticks[2], ticks[3], ticks[4],
+          BENCH_BYTES / (1024 * 1024));
+}
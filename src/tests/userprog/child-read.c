@@ -0,0 +1,19 @@
+/* Child process run by the thread-exit-wait test.
+   Reads its standard input until end of file. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-read";
+
+int
+main (void) 
+{
+  char buf[64];
+
+  while (read (STDIN_FILENO, buf, sizeof buf) > 0)
+    continue;
+  msg ("end of file");
+  return 0;
+}
@@ -0,0 +1,34 @@
+/* Duplicates a file descriptor with dup2 and checks that the two
+   descriptors share one file position, and that closing one
+   leaves the other open. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define COPY_FD 10
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (dup2 (handle, COPY_FD) == COPY_FD, "dup2");
+  if (read (handle, buf, half) != (int) half)
+    fail ("read first half failed");
+  CHECK (tell (COPY_FD) == half, "copy is at the original's position");
+  if (read (COPY_FD, buf + half, size - half) != (int) (size - half))
+    fail ("read second half failed");
+  compare_bytes (buf, sample, size, 0, "sample.txt");
+  CHECK (tell (handle) == size, "original is at the copy's position");
+
+  close (COPY_FD);
+  seek (handle, 0);
+  CHECK (read (handle, buf, 1) == 1, "original still open after close");
+  close (handle);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dup2-shared) begin
+(dup2-shared) open "sample.txt"
+(dup2-shared) dup2
+(dup2-shared) copy is at the original's position
+(dup2-shared) original is at the copy's position
+(dup2-shared) original still open after close
+(dup2-shared) end
+dup2-shared: exit(0)
+EOF
+pass;
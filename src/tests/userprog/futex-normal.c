@@ -0,0 +1,22 @@
+/* Checks the cases of futex_wait and futex_wake that need only
+   one thread: waiting when the word has changed returns at once,
+   waking with nobody waiting wakes nobody, and a misaligned word
+   is refused. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word[2];
+
+void
+test_main (void) 
+{
+  word[0] = 1;
+  CHECK (futex_wait (&word[0], 0) == -1, "futex_wait on changed word");
+  CHECK (futex_wake (&word[0], 1) == 0, "futex_wake with no waiters");
+  CHECK (futex_wait ((int *) ((char *) word + 1), 1) == -1,
+         "futex_wait on misaligned word");
+  CHECK (futex_wake ((int *) ((char *) word + 1), 1) == -1,
+         "futex_wake on misaligned word");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-normal) begin
+(futex-normal) futex_wait on changed word
+(futex-normal) futex_wake with no waiters
+(futex-normal) futex_wait on misaligned word
+(futex-normal) futex_wake on misaligned word
+(futex-normal) end
+futex-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Passes data through a pipe, enough of it that the pipe's
+   buffer wraps around, and checks that the read end sees end of
+   file once the write end is closed, and that writing fails once
+   the read end is closed. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* More than half a page, so the second pass wraps around. */
+#define CHUNK 3000
+
+static char out[CHUNK];
+static char in[CHUNK];
+
+void
+test_main (void) 
+{
+  int fds[2];
+  int pass;
+  size_t i;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "got two new descriptors");
+  for (pass = 0; pass < 2; pass++)
+    {
+      for (i = 0; i < CHUNK; i++)
+        out[i] = i * 7 + pass;
+      if (write (fds[1], out, CHUNK) != CHUNK)
+        fail ("write to pipe failed");
+      if (read (fds[0], in, CHUNK) != CHUNK)
+        fail ("read from pipe failed");
+      compare_bytes (in, out, CHUNK, 0, "pipe");
+    }
+  msg ("passed data through pipe");
+
+  close (fds[1]);
+  CHECK (read (fds[0], in, CHUNK) == 0, "read end of file");
+  close (fds[0]);
+
+  CHECK (pipe (fds) == 0, "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], out, CHUNK) == -1, "write with no reader fails");
+  close (fds[1]);
+}
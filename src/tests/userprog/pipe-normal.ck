@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-normal) begin
+(pipe-normal) pipe
+(pipe-normal) got two new descriptors
+(pipe-normal) passed data through pipe
+(pipe-normal) read end of file
+(pipe-normal) pipe
+(pipe-normal) write with no reader fails
+(pipe-normal) end
+pipe-normal: exit(0)
+EOF
+pass;
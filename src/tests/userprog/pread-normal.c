@@ -0,0 +1,34 @@
+/* Reads and writes a file at explicit offsets with pread and
+   pwrite, and checks that neither moves the file position. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  size_t ofs = size / 3;
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = pread (handle, buf, size - ofs, ofs);
+  if (byte_cnt != (int) (size - ofs))
+    fail ("pread() returned %d instead of %zu", byte_cnt, size - ofs);
+  compare_bytes (buf, sample + ofs, size - ofs, ofs, "sample.txt");
+  CHECK (tell (handle) == 0, "pread left position at 0");
+  close (handle);
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (pwrite (handle, sample + ofs, size - ofs, ofs) == (int) (size - ofs),
+         "pwrite tail");
+  CHECK (pwrite (handle, sample, ofs, 0) == (int) ofs, "pwrite head");
+  CHECK (tell (handle) == 0, "pwrite left position at 0");
+  close (handle);
+
+  check_file ("test.txt", sample, size);
+}
@@ -0,0 +1,44 @@
+/* Starts a child that reads, from a pipe, until end of file, and
+   a thread that waits for the child, then calls exit() from the
+   main thread while it still holds the pipe's write end.  The
+   process must close its descriptors as it ends, so that the
+   child and then the waiting thread can finish. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char stack[4096];
+static volatile int waiting;
+
+static void
+waiter (void *aux UNUSED)
+{
+  pid_t child = exec ("child-read");
+
+  if (child == PID_ERROR)
+    fail ("exec child-read");
+  waiting = 1;
+  wait (child);
+  fail ("wait returned");
+}
+
+void
+test_main (void) 
+{
+  int fds[2];
+  volatile int i;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (dup2 (fds[0], STDIN_FILENO) == STDIN_FILENO, "dup2");
+  CHECK (spawn_thread (waiter, NULL, stack + sizeof stack) != TID_ERROR,
+         "spawn waiter");
+
+  /* Give the waiter time to reach wait(). */
+  while (!waiting)
+    continue;
+  for (i = 0; i < 10000000; i++)
+    continue;
+  exit (57);
+}
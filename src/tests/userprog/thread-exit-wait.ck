@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-exit-wait) begin
+(thread-exit-wait) pipe
+(thread-exit-wait) dup2
+(thread-exit-wait) spawn waiter
+(child-read) end of file
+child-read: exit(0)
+thread-exit-wait: exit(57)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Spawns a thread that computes without making system calls and
+   one that waits to read a pipe that never gets data, then calls
+   exit() from the main thread, which must end the process with
+   both of them still running. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char stacks[2][4096];
+static int fds[2];
+
+static void
+spinner (void *aux UNUSED)
+{
+  volatile int i = 0;
+
+  for (;;)
+    i++;
+}
+
+static void
+reader (void *aux UNUSED)
+{
+  char c;
+
+  read (fds[0], &c, 1);
+  fail ("read returned");
+}
+
+void
+test_main (void) 
+{
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (spawn_thread (spinner, NULL, stacks[0] + sizeof stacks[0])
+         != TID_ERROR, "spawn spinner");
+  CHECK (spawn_thread (reader, NULL, stacks[1] + sizeof stacks[1])
+         != TID_ERROR, "spawn pipe reader");
+  exit (57);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-exit) begin
+(thread-exit) pipe
+(thread-exit) spawn spinner
+(thread-exit) spawn pipe reader
+thread-exit: exit(57)
+EOF
+pass;
@@ -0,0 +1,80 @@
+/* Spawns several threads that each add to a counter shared with
+   the others, guarded by a lock built on futex_wait and
+   futex_wake, and record their argument in a slot of their own.
+   Joins every thread and checks what they did, and that joining
+   a thread twice or one that does not exist fails. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ADD_CNT 1000
+
+static char stacks[THREAD_CNT][4096];
+static int slots[THREAD_CNT];
+static int lock_word;
+static int counter;
+
+/* Atomically stores NEW in *ADDR and returns its old value. */
+static int
+exchange (int *addr, int new)
+{
+  asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*addr) : : "memory");
+  return new;
+}
+
+/* Acquires the lock: 0 means free, 1 held, 2 held with waiters. */
+static void
+lock (void)
+{
+  while (exchange (&lock_word, 2) != 0)
+    futex_wait (&lock_word, 2);
+}
+
+static void
+unlock (void)
+{
+  if (exchange (&lock_word, 0) == 2)
+    futex_wake (&lock_word, 1);
+}
+
+static void
+worker (void *aux)
+{
+  int idx = (int) aux;
+  int i;
+
+  for (i = 0; i < ADD_CNT; i++)
+    {
+      lock ();
+      counter++;
+      unlock ();
+    }
+  slots[idx] = idx + 1;
+  exit_thread ();
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = spawn_thread (worker, (void *) i,
+                                    stacks[i] + sizeof stacks[i]))
+           != TID_ERROR, "spawn thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (join_thread (tids[i]) == 0, "join thread %d", i);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    if (slots[i] != i + 1)
+      fail ("thread %d left %d in its slot", i, slots[i]);
+  if (counter != THREAD_CNT * ADD_CNT)
+    fail ("counter is %d, should be %d", counter, THREAD_CNT * ADD_CNT);
+  msg ("counter is %d", counter);
+
+  CHECK (join_thread (tids[0]) == -1, "join thread 0 again");
+  CHECK (join_thread (12345) == -1, "join nonexistent thread");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-join) begin
+(thread-join) spawn thread 0
+(thread-join) spawn thread 1
+(thread-join) spawn thread 2
+(thread-join) spawn thread 3
+(thread-join) join thread 0
+(thread-join) join thread 1
+(thread-join) join thread 2
+(thread-join) join thread 3
+(thread-join) counter is 4000
+(thread-join) join thread 0 again
+(thread-join) join nonexistent thread
+(thread-join) end
+thread-join: exit(0)
+EOF
+pass;
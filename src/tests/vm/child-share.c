@@ -0,0 +1,39 @@
+/* Child process of page-share.
+   Checks that its initialized data is as the executable has it,
+   fills a page of it with its own id, and checks, after giving
+   the other children time to do the same, that the page still
+   holds only its own id.  Returns the id. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-share";
+
+#define SIZE 4096
+#define ORIGINAL "original data"
+
+static char data[SIZE] = ORIGINAL;
+
+int
+main (int argc, char *argv[])
+{
+  int id = atoi (argv[argc - 1]);
+  volatile int spin;
+  size_t i;
+
+  quiet = true;
+  if (strcmp (data, ORIGINAL))
+    fail ("data was already changed to \"%.20s\"", data);
+  memset (data, 'a' + id, SIZE);
+
+  /* Long enough to cross several time slices. */
+  for (spin = 0; spin < 20000000; spin++)
+    continue;
+
+  for (i = 0; i < SIZE; i++)
+    if (data[i] != 'a' + id)
+      fail ("byte %zu changed to '%c' by another process", i, data[i]);
+  return id;
+}
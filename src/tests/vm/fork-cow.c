@@ -0,0 +1,33 @@
+/* Forks a child that overwrites a large array it shares
+   copy-on-write with its parent, then checks that the parent's
+   copy of the array is unchanged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  memset (buf, 'p', SIZE);
+  child = fork ();
+  if (child == 0)
+    {
+      memset (buf, 'c', SIZE);
+      exit (buf[0] == 'c' && buf[SIZE - 1] == 'c' ? 81 : -1);
+    }
+  CHECK (child != PID_ERROR, "fork");
+  CHECK (wait (child) == 81, "wait for child");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 'p')
+      fail ("byte %zu changed to '%c' by child", i, buf[i]);
+  msg ("parent's copy intact");
+}
@@ -0,0 +1,28 @@
+/* Runs several copies of one executable at once, which may share
+   its read-only text, and checks that each one works and that
+   none sees another's writes to its initialized data. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  char cmd[32];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      snprintf (cmd, sizeof cmd, "child-share %d", i);
+      CHECK ((children[i] = exec (cmd)) != PID_ERROR,
+             "exec \"%s\"", cmd);
+    }
+
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (children[i]) == i, "wait for child %d", i);
+}
@@ -0,0 +1,41 @@
+/* Reads every page of a large array that has never been written,
+   which may all be backed by one shared page of zeros, and checks
+   that it is all zeros.  Then writes one page and checks that the
+   write shows up there and nowhere else. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Checks that every byte of BUF, apart from page SKIP, is zero. */
+static void
+check_zeros (int skip)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0 && i / PAGE_SIZE != (size_t) skip)
+      fail ("byte %zu is %d, not 0", i, buf[i]);
+}
+
+void
+test_main (void)
+{
+  int page = PAGE_CNT / 2;
+  size_t i;
+
+  check_zeros (-1);
+  msg ("untouched array reads as zeros");
+
+  memset (buf + page * PAGE_SIZE, 0x5a, PAGE_SIZE);
+  for (i = 0; i < PAGE_SIZE; i++)
+    if (buf[page * PAGE_SIZE + i] != 0x5a)
+      fail ("written byte %zu is %d", i, buf[page * PAGE_SIZE + i]);
+  check_zeros (page);
+  msg ("write to one page left the others zero");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-zero) begin
+(page-zero) untouched array reads as zeros
+(page-zero) write to one page left the others zero
+(page-zero) end
+EOF
+pass;
@@ -22,6 +22,7 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -31,6 +32,11 @@
 #else
 #include "tests/threads/tests.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "devices/ide.h"
@@ -98,6 +104,10 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+#ifdef VM
+  frame_init ();
+  page_init ();
+#endif
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -113,6 +123,7 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  process_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
@@ -126,6 +137,9 @@ main (void)
   locate_block_devices ();
   filesys_init (format_filesys);
 #endif
+#ifdef VM
+  swap_init ();
+#endif
 
   printf ("Boot complete.\n");
   
@@ -251,6 +265,16 @@ parse_options (char **argv)
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
 #endif
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-sl"))
+        {
+          int kb = value != NULL ? atoi (value) : 0;
+          if (kb <= 0 || (size_t) kb >= (uintptr_t) PHYS_BASE / 1024)
+            PANIC ("-sl requires a stack limit from 1 to %"PRIuPTR" kB",
+                   (uintptr_t) PHYS_BASE / 1024 - 1);
+          stack_limit = (size_t) kb * 1024;
+        }
 #endif
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
@@ -376,6 +400,9 @@ usage (void)
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
+#endif
+#ifdef VM
+          "  -sl=KB             Limit each user stack to KB kB.\n"
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
@@ -5,8 +5,10 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -32,7 +34,38 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   Each thread also keeps a small cache of free blocks of each
+   size, so that most calls to malloc() and free() take no lock.
+   malloc() takes a block from the running thread's cache, and
+   free() puts it back there.  Only when the cache runs empty
+   or full does the thread take the descriptor's lock, and then
+   it moves CACHE_BATCH blocks at once.  Blocks in a cache count
+   as in use in their arenas, so an arena is not freed while any
+   of its blocks is cached.  A thread hands its cached blocks
+   back with malloc_drain_cache() before it dies.
+
+   Every descriptor, and big blocks as a group, count the calls
+   made on them and the bytes their callers hold.  If MALLOC_DEBUG
+   is defined (for example, by adding -DMALLOC_DEBUG to DEFINES),
+   malloc() also records which function asked for each block, and
+   malloc_print_stats() lists the blocks that are still live. */
+
+/* Maximum number of free blocks of each size in a thread's
+   cache, and the number moved to or from a descriptor at once. */
+#define CACHE_SIZE 16
+#define CACHE_BATCH (CACHE_SIZE / 2)
+
+/* Allocation counters.  Updated with interrupts off, because
+   the common paths through malloc() and free() take no lock. */
+struct usage
+  {
+    unsigned long long alloc_cnt; /* Number of allocations. */
+    unsigned long long free_cnt;  /* Number of frees. */
+    size_t bytes;               /* Bytes allocated and not yet freed. */
+    size_t peak_bytes;          /* Maximum of BYTES. */
+  };
 
 /* Descriptor. */
 struct desc
@@ -41,6 +74,7 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    struct usage usage;         /* Blocks handed out by malloc(). */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -57,15 +91,53 @@ struct arena
 /* Free block. */
 struct block 
   {
-    struct list_elem free_elem; /* Free list element. */
+    union
+      {
+        struct list_elem free_elem; /* Free list element. */
+        struct block *next;         /* Next block in a thread's cache. */
+      };
   };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[MALLOC_DESC_CNT]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Usage of blocks too big for any descriptor. */
+static struct usage big_usage;
+
+#ifdef MALLOC_DEBUG
+/* Number of live blocks whose callers can be recorded. */
+#define TRACE_CNT 4096
+
+/* Marks a TRACES slot whose block has been freed. */
+#define TRACE_FREED ((void *) 1)
+
+/* A live block and where it came from. */
+struct trace
+  {
+    void *block;                /* Block, null, or TRACE_FREED. */
+    void *caller;               /* Return address of malloc() call. */
+    size_t size;                /* Bytes requested. */
+  };
+
+/* Open-addressed hash table of live blocks, keyed by address.
+   Accessed with interrupts off. */
+static struct trace traces[TRACE_CNT];
+static size_t untraced_cnt;     /* Blocks not recorded: table full. */
+
+static void trace_add (void *block, size_t size, void *caller);
+static void trace_remove (void *block);
+static void trace_print (void);
+#endif
+
+static void *malloc_from (size_t size, void *caller);
+static void usage_add (struct usage *, size_t bytes);
+static void usage_sub (struct usage *, size_t bytes);
+static void usage_print (const char *name, const struct usage *);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static bool cache_refill (struct desc *, struct malloc_cache *);
+static void cache_drain (struct desc *, struct malloc_cache *, size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -82,14 +154,24 @@ malloc_init (void)
       list_init (&d->free_list);
       lock_init (&d->lock);
     }
+  ASSERT (desc_cnt == MALLOC_DESC_CNT);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) 
+{
+  return malloc_from (size, __builtin_return_address (0));
+}
+
+/* Does the work of malloc() for a request for SIZE bytes made by
+   the function that will return to CALLER. */
+static void *
+malloc_from (size_t size, void *caller UNUSED)
 {
   struct desc *d;
+  struct malloc_cache *c;
   struct block *b;
   struct arena *a;
 
@@ -116,40 +198,25 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = NULL;
       a->free_cnt = page_cnt;
+      usage_add (&big_usage, page_cnt * PGSIZE);
+#ifdef MALLOC_DEBUG
+      trace_add (a + 1, size, caller);
+#endif
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
-    {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
-    }
-
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
-  lock_release (&d->lock);
+  /* Take a block from the running thread's cache, refilling
+     it from the descriptor if it is empty. */
+  c = &thread_current ()->malloc_caches[d - descs];
+  if (c->cnt == 0 && !cache_refill (d, c))
+    return NULL;
+  b = c->blocks;
+  c->blocks = b->next;
+  c->cnt--;
+  usage_add (&d->usage, d->block_size);
+#ifdef MALLOC_DEBUG
+  trace_add (b, size, caller);
+#endif
   return b;
 }
 
@@ -167,7 +234,7 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = malloc_from (size, __builtin_return_address (0));
   if (p != NULL)
     memset (p, 0, size);
 
@@ -201,7 +268,8 @@ realloc (void *old_block, size_t new_size)
     }
   else 
     {
-      void *new_block = malloc (new_size);
+      void *new_block = malloc_from (new_size,
+                                     __builtin_return_address (0));
       if (old_block != NULL && new_block != NULL)
         {
           size_t old_size = block_size (old_block);
@@ -223,46 +291,267 @@ free (void *p)
       struct block *b = p;
       struct arena *a = block_to_arena (b);
       struct desc *d = a->desc;
+
+#ifdef MALLOC_DEBUG
+      trace_remove (b);
+#endif
       
       if (d != NULL) 
         {
           /* It's a normal block.  We handle it here. */
+          struct malloc_cache *c
+            = &thread_current ()->malloc_caches[d - descs];
+
+          usage_sub (&d->usage, d->block_size);
 
 #ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
-            {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
-            }
-
-          lock_release (&d->lock);
+          /* Put the block in the running thread's cache, first
+             making room if the cache is full. */
+          if (c->cnt >= CACHE_SIZE)
+            cache_drain (d, c, CACHE_BATCH);
+          b->next = c->blocks;
+          c->blocks = b;
+          c->cnt++;
         }
       else
         {
           /* It's a big block.  Free its pages. */
+          usage_sub (&big_usage, a->free_cnt * PGSIZE);
           palloc_free_multiple (a, a->free_cnt);
           return;
         }
     }
 }
 
+/* Prints allocation counters for each descriptor and for big
+   blocks, and, if MALLOC_DEBUG is defined, the blocks that have
+   not been freed. */
+void
+malloc_print_stats (void)
+{
+  size_t i;
+
+  for (i = 0; i < desc_cnt; i++)
+    {
+      char name[32];
+      snprintf (name, sizeof name, "%zu-byte blocks", descs[i].block_size);
+      usage_print (name, &descs[i].usage);
+    }
+  usage_print ("big blocks", &big_usage);
+#ifdef MALLOC_DEBUG
+  trace_print ();
+#endif
+}
+
+/* Returns all of the running thread's cached blocks to their
+   descriptors.  Called by a thread that is about to exit. */
+void
+malloc_drain_cache (void)
+{
+  struct thread *t = thread_current ();
+  size_t i;
+
+  for (i = 0; i < desc_cnt; i++)
+    cache_drain (&descs[i], &t->malloc_caches[i], t->malloc_caches[i].cnt);
+}
+
+/* Moves up to CACHE_BATCH free blocks from descriptor D into
+   cache C, creating new arenas as needed.  Returns true if at
+   least one block was moved, false if memory is exhausted. */
+static bool
+cache_refill (struct desc *d, struct malloc_cache *c)
+{
+  lock_acquire (&d->lock);
+  while (c->cnt < CACHE_BATCH)
+    {
+      struct block *b;
+      struct arena *a;
+
+      /* If the free list is empty, create a new arena. */
+      if (list_empty (&d->free_list))
+        {
+          size_t i;
+
+          /* Allocate a page. */
+          a = palloc_get_page (0);
+          if (a == NULL)
+            break;
+
+          /* Initialize arena and add its blocks to the free list. */
+          a->magic = ARENA_MAGIC;
+          a->desc = d;
+          a->free_cnt = d->blocks_per_arena;
+          for (i = 0; i < d->blocks_per_arena; i++) 
+            {
+              struct block *b = arena_to_block (a, i);
+              list_push_back (&d->free_list, &b->free_elem);
+            }
+        }
+
+      /* Move a block from the free list to the cache. */
+      b = list_entry (list_pop_front (&d->free_list),
+                      struct block, free_elem);
+      a = block_to_arena (b);
+      a->free_cnt--;
+      b->next = c->blocks;
+      c->blocks = b;
+      c->cnt++;
+    }
+  lock_release (&d->lock);
+
+  return c->cnt > 0;
+}
+
+/* Moves CNT blocks from cache C back to descriptor D's free
+   list, freeing any arena that is left with no blocks in use. */
+static void
+cache_drain (struct desc *d, struct malloc_cache *c, size_t cnt)
+{
+  ASSERT (cnt <= c->cnt);
+
+  if (cnt == 0)
+    return;
+
+  lock_acquire (&d->lock);
+  for (; cnt > 0; cnt--)
+    {
+      struct block *b = c->blocks;
+      struct arena *a = block_to_arena (b);
+
+      c->blocks = b->next;
+      c->cnt--;
+
+      /* Add block to free list. */
+      list_push_front (&d->free_list, &b->free_elem);
+
+      /* If the arena is now entirely unused, free it. */
+      if (++a->free_cnt >= d->blocks_per_arena) 
+        {
+          size_t i;
+
+          ASSERT (a->free_cnt == d->blocks_per_arena);
+          for (i = 0; i < d->blocks_per_arena; i++) 
+            {
+              struct block *b = arena_to_block (a, i);
+              list_remove (&b->free_elem);
+            }
+          palloc_free_page (a);
+        }
+    }
+  lock_release (&d->lock);
+}
+
+/* Counts an allocation of BYTES bytes in U. */
+static void
+usage_add (struct usage *u, size_t bytes)
+{
+  enum intr_level old_level = intr_disable ();
+  u->alloc_cnt++;
+  u->bytes += bytes;
+  if (u->bytes > u->peak_bytes)
+    u->peak_bytes = u->bytes;
+  intr_set_level (old_level);
+}
+
+/* Counts a free of BYTES bytes in U. */
+static void
+usage_sub (struct usage *u, size_t bytes)
+{
+  enum intr_level old_level = intr_disable ();
+  u->free_cnt++;
+  u->bytes -= bytes;
+  intr_set_level (old_level);
+}
+
+/* Prints U, which describes the blocks named by NAME. */
+static void
+usage_print (const char *name, const struct usage *u)
+{
+  printf ("malloc %s: %llu allocations, %llu frees, "
+          "%zu bytes in use, peak %zu\n",
+          name, u->alloc_cnt, u->free_cnt, u->bytes, u->peak_bytes);
+}
+
+#ifdef MALLOC_DEBUG
+/* Returns the first TRACES slot to probe for BLOCK. */
+static size_t
+trace_hash (void *block)
+{
+  return ((uintptr_t) block >> 4) % TRACE_CNT;
+}
+
+/* Records that CALLER obtained BLOCK, of SIZE bytes. */
+static void
+trace_add (void *block, size_t size, void *caller)
+{
+  enum intr_level old_level = intr_disable ();
+  size_t h = trace_hash (block);
+  size_t i;
+
+  for (i = 0; i < TRACE_CNT; i++)
+    {
+      struct trace *t = &traces[(h + i) % TRACE_CNT];
+      if (t->block == NULL || t->block == TRACE_FREED)
+        {
+          t->block = block;
+          t->caller = caller;
+          t->size = size;
+          break;
+        }
+    }
+  if (i == TRACE_CNT)
+    untraced_cnt++;
+  intr_set_level (old_level);
+}
+
+/* Forgets BLOCK, which is being freed. */
+static void
+trace_remove (void *block)
+{
+  enum intr_level old_level = intr_disable ();
+  size_t h = trace_hash (block);
+  size_t i;
+
+  for (i = 0; i < TRACE_CNT; i++)
+    {
+      struct trace *t = &traces[(h + i) % TRACE_CNT];
+      if (t->block == block)
+        {
+          t->block = TRACE_FREED;
+          break;
+        }
+      else if (t->block == NULL)
+        break;
+    }
+  intr_set_level (old_level);
+}
+
+/* Prints every block that has been allocated but not freed. */
+static void
+trace_print (void)
+{
+  size_t live_cnt = 0;
+  size_t i;
+
+  for (i = 0; i < TRACE_CNT; i++)
+    {
+      struct trace *t = &traces[i];
+      if (t->block != NULL && t->block != TRACE_FREED)
+        {
+          printf ("malloc: live block %p, %zu bytes, from %p\n",
+                  t->block, t->size, t->caller);
+          live_cnt++;
+        }
+    }
+  printf ("malloc: %zu live blocks; %zu allocations not recorded\n",
+          live_cnt, untraced_cnt);
+}
+#endif
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -4,10 +4,23 @@
 #include <debug.h>
 #include <stddef.h>
 
+/* Number of block sizes that malloc() carves out of arenas. */
+#define MALLOC_DESC_CNT 7
+
+/* A thread's private stock of free blocks of one size.  malloc()
+   and free() use it without taking the descriptor's lock. */
+struct malloc_cache
+  {
+    void *blocks;               /* Singly linked list of free blocks. */
+    size_t cnt;                 /* Number of blocks in BLOCKS. */
+  };
+
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_drain_cache (void);
+void malloc_print_stats (void);
 
 #endif /* threads/malloc.h */
@@ -1,12 +1,13 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -23,14 +24,74 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, pages are managed by a binary buddy allocator.
+   Free memory is kept as blocks of 2**ORDER pages, each aligned
+   to its size relative to the pool base, on one free list per
+   order.  A request for PAGE_CNT pages takes the first block on
+   the list for the smallest order that fits, splitting a larger
+   block if that list is empty, and gives back the pages past
+   PAGE_CNT.  A freed block is merged with its "buddy", the other
+   half of the block one order up, for as long as the buddy is
+   free too.  Both take O(log n) time in the size of the pool,
+   instead of the linear scan of a bitmap.
+
+   The free lists and page states are protected by disabling
+   interrupts rather than by the pool's lock, because the
+   scheduler frees a dying thread's page with interrupts off,
+   when it cannot wait for a lock.  Each critical section is
+   only O(log n) steps long.
+
+   Each pool also keeps a few free pages that have already been
+   zeroed, so that PAL_ZERO requests for a single page need not
+   clear it on the caller's time.  The idle thread refills them
+   with palloc_zero_idle() when there is nothing else to do.  The
+   pages count as allocated in the buddy system, so they are
+   handed back to it when the pool would otherwise run dry. */
+
+/* Number of pre-zeroed pages kept in each pool. */
+#define ZEROED_PAGES 16
+
+/* Largest block order: blocks hold at most 2**MAX_ORDER pages. */
+#define MAX_ORDER 10
+
+/* Returned by block_alloc() and range_alloc() on failure. */
+#define BLOCK_ERROR SIZE_MAX
+
+/* State of a page, one byte per page.  The first page of a free
+   block holds FREE_HEAD plus the block's order, the other pages
+   of a free block hold 0, and allocated pages hold PAGE_USED. */
+#define FREE_HEAD 0x80                  /* Starts a free block. */
+#define PAGE_USED 0x40                  /* Allocated. */
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    uint8_t *state;                     /* State of each page. */
+    struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+    size_t page_cnt;                    /* Number of pages. */
+    size_t free_cnt;                    /* Number of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* Name, for statistics. */
+
+    void *zeroed[ZEROED_PAGES];         /* Pre-zeroed free pages. */
+    size_t zeroed_cnt;                  /* Number of pages in ZEROED. */
+    unsigned long long zero_hits;       /* PAL_ZERO pages from ZEROED. */
+    unsigned long long zero_misses;     /* PAL_ZERO pages cleared late. */
+
+    /* Usage, updated with interrupts off. */
+    unsigned long long alloc_calls;     /* Successful allocations. */
+    unsigned long long free_calls;      /* Frees. */
+    size_t used_pages;                  /* Pages handed out, not freed. */
+    size_t peak_pages;                  /* Maximum of USED_PAGES. */
+  };
+
+/* A free block of pages, stored in the block's first page. */
+struct free_block
+  {
+    struct list_elem elem;              /* Element in a free list. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +100,10 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t range_alloc (struct pool *, size_t page_cnt);
+static void range_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void release_zeroed (struct pool *);
+static bool refill_zeroed (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -66,29 +131,62 @@ palloc_init (size_t user_page_limit)
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   FLAGS, in which case the kernel panics.  At most 2**MAX_ORDER
+   pages may be obtained at once. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
   size_t page_idx;
+  bool zeroed = false;
 
   if (page_cnt == 0)
     return NULL;
 
   lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
-
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
+  if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zeroed_cnt > 0)
+    {
+      pages = pool->zeroed[--pool->zeroed_cnt];
+      zeroed = true;
+    }
   else
-    pages = NULL;
+    {
+      page_idx = range_alloc (pool, page_cnt);
+      if (page_idx == BLOCK_ERROR && pool->zeroed_cnt > 0)
+        {
+          release_zeroed (pool);
+          page_idx = range_alloc (pool, page_cnt);
+        }
+      if (page_idx != BLOCK_ERROR)
+        pages = pool->base + PGSIZE * page_idx;
+      else
+        pages = NULL;
+    }
+  if (pages != NULL)
+    {
+      enum intr_level old_level;
+
+      if (flags & PAL_ZERO)
+        {
+          if (zeroed)
+            pool->zero_hits++;
+          else
+            pool->zero_misses++;
+        }
+
+      old_level = intr_disable ();
+      pool->alloc_calls++;
+      pool->used_pages += page_cnt;
+      if (pool->used_pages > pool->peak_pages)
+        pool->peak_pages = pool->used_pages;
+      intr_set_level (old_level);
+    }
+  lock_release (&pool->lock);
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else 
@@ -119,6 +217,8 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
+  size_t i;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
@@ -137,8 +237,16 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  old_level = intr_disable ();
+  for (i = 0; i < page_cnt; i++)
+    {
+      ASSERT (pool->state[page_idx + i] == PAGE_USED);
+      pool->state[page_idx + i] = 0;
+    }
+  range_free (pool, page_idx, page_cnt);
+  pool->free_calls++;
+  pool->used_pages -= page_cnt;
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +256,158 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Zeroes one free page for a pool whose supply of pre-zeroed
+   pages is short.  Called by the idle thread, so it never waits
+   for a lock: a pool that is busy is skipped.  Returns true if a
+   page was zeroed, false if there was nothing to do. */
+bool
+palloc_zero_idle (void)
+{
+  return refill_zeroed (&user_pool) || refill_zeroed (&kernel_pool);
+}
+
+/* Prints, for each pool, how many pages its callers hold now and
+   at most, statistics about pre-zeroed pages, and a fragmentation
+   report: how many of its pages are free, how many free blocks
+   there are of each order, and the largest run of pages that a
+   single request could still obtain. */
+void
+palloc_print_stats (void)
+{
+  struct pool *pools[] = {&kernel_pool, &user_pool};
+  size_t i;
+
+  for (i = 0; i < sizeof pools / sizeof *pools; i++)
+    {
+      struct pool *p = pools[i];
+      unsigned long long total = p->zero_hits + p->zero_misses;
+      size_t largest = 0;
+      enum intr_level old_level;
+      int order;
+
+      printf ("Pages in %s: %llu allocations, %llu frees, "
+              "%zu pages in use, peak %zu\n",
+              p->name, p->alloc_calls, p->free_calls, p->used_pages,
+              p->peak_pages);
+      printf ("Zeroed pages in %s: %llu of %llu PAL_ZERO requests "
+              "(%llu%%), %zu ready\n",
+              p->name, p->zero_hits, total,
+              total > 0 ? p->zero_hits * 100 / total : 0, p->zeroed_cnt);
+
+      old_level = intr_disable ();
+      printf ("Free blocks in %s:", p->name);
+      for (order = 0; order <= MAX_ORDER; order++)
+        {
+          size_t cnt = list_size (&p->free_lists[order]);
+          printf (" %zu", cnt);
+          if (cnt > 0)
+            largest = (size_t) 1 << order;
+        }
+      printf (" (orders 0-%d); %zu of %zu pages free, largest %zu\n",
+              MAX_ORDER, p->free_cnt, p->page_cnt, largest);
+      intr_set_level (old_level);
+    }
+}
+
+/* Returns all of POOL's pre-zeroed pages to its free lists.
+   POOL's lock must be held. */
+static void
+release_zeroed (struct pool *pool)
+{
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  while (pool->zeroed_cnt > 0)
+    {
+      size_t page_idx = pg_no (pool->zeroed[--pool->zeroed_cnt])
+                        - pg_no (pool->base);
+      enum intr_level old_level = intr_disable ();
+      pool->state[page_idx] = 0;
+      range_free (pool, page_idx, 1);
+      intr_set_level (old_level);
+    }
+}
+
+/* Zeroes a free page of POOL and adds it to POOL's pre-zeroed
+   pages, if there is room for it and POOL's lock is free.  The
+   page is taken from the free lists first and cleared with no
+   lock held.  The lock is held only with interrupts off, since
+   the idle thread, once preempted, runs again only when no other
+   thread is ready, and anyone allocating a page would wait for
+   it until then.  Returns true if successful. */
+static bool
+refill_zeroed (struct pool *pool)
+{
+  enum intr_level old_level;
+  size_t page_idx = BLOCK_ERROR;
+  void *page;
+  bool success = false;
+
+  old_level = intr_disable ();
+  if (pool->zeroed_cnt < ZEROED_PAGES && lock_try_acquire (&pool->lock))
+    {
+      page_idx = range_alloc (pool, 1);
+      lock_release (&pool->lock);
+    }
+  intr_set_level (old_level);
+  if (page_idx == BLOCK_ERROR)
+    return false;
+
+  page = pool->base + PGSIZE * page_idx;
+  memset (page, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  if (lock_try_acquire (&pool->lock))
+    {
+      if (pool->zeroed_cnt < ZEROED_PAGES)
+        {
+          pool->zeroed[pool->zeroed_cnt++] = page;
+          success = true;
+        }
+      lock_release (&pool->lock);
+    }
+  if (!success)
+    {
+      /* Someone else got there first.  Give the page back. */
+      pool->state[page_idx] = 0;
+      range_free (pool, page_idx, 1);
+    }
+  intr_set_level (old_level);
+  return success;
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's page states at its base.
+     Calculate the space needed for them
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  size_t state_pages = DIV_ROUND_UP (page_cnt, PGSIZE);
+  int order;
+  if (state_pages > page_cnt)
+    PANIC ("Not enough memory in %s for page states.", name);
+  page_cnt -= state_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->state = base;
+  memset (p->state, 0, page_cnt);
+  for (order = 0; order <= MAX_ORDER; order++)
+    list_init (&p->free_lists[order]);
+  p->page_cnt = page_cnt;
+  p->free_cnt = 0;
+  p->base = base + state_pages * PGSIZE;
+  p->name = name;
+  p->zeroed_cnt = 0;
+  p->zero_hits = p->zero_misses = 0;
+  p->alloc_calls = p->free_calls = 0;
+  p->used_pages = p->peak_pages = 0;
+
+  /* Hand all the pages to the buddy system. */
+  range_free (p, 0, page_cnt);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +417,141 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free block header in POOL's page PAGE_IDX. */
+static struct free_block *
+block_at (const struct pool *pool, size_t page_idx)
+{
+  return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the free block of 2**ORDER pages at PAGE_IDX to POOL's
+   free lists. */
+static void
+block_insert (struct pool *pool, size_t page_idx, int order)
+{
+  pool->state[page_idx] = FREE_HEAD | order;
+  list_push_front (&pool->free_lists[order],
+                   &block_at (pool, page_idx)->elem);
+}
+
+/* Takes the free block at PAGE_IDX off POOL's free lists. */
+static void
+block_remove (struct pool *pool, size_t page_idx)
+{
+  pool->state[page_idx] = 0;
+  list_remove (&block_at (pool, page_idx)->elem);
+}
+
+/* Returns true if the page at PAGE_IDX in POOL starts a free
+   block of exactly 2**ORDER pages. */
+static bool
+block_is_free (const struct pool *pool, size_t page_idx, int order)
+{
+  return (page_idx + ((size_t) 1 << order) <= pool->page_cnt
+          && pool->state[page_idx] == (FREE_HEAD | order));
+}
+
+/* Removes a free block of 2**ORDER pages from POOL, splitting a
+   larger one if necessary, and returns the index of its first
+   page, or BLOCK_ERROR if there is none. */
+static size_t
+block_alloc (struct pool *pool, int order)
+{
+  size_t page_idx;
+  int k;
+
+  for (k = order; k <= MAX_ORDER; k++)
+    if (!list_empty (&pool->free_lists[k]))
+      break;
+  if (k > MAX_ORDER)
+    return BLOCK_ERROR;
+
+  page_idx = pg_no (list_entry (list_front (&pool->free_lists[k]),
+                                struct free_block, elem))
+             - pg_no (pool->base);
+  block_remove (pool, page_idx);
+
+  /* Put the upper halves back until the block is small enough. */
+  while (k > order)
+    {
+      k--;
+      block_insert (pool, page_idx + ((size_t) 1 << k), k);
+    }
+  return page_idx;
+}
+
+/* Returns the block of 2**ORDER pages at PAGE_IDX to POOL,
+   merging it with its buddy for as long as the buddy is free. */
+static void
+block_free (struct pool *pool, size_t page_idx, int order)
+{
+  while (order < MAX_ORDER)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+      if (!block_is_free (pool, buddy_idx, order))
+        break;
+      block_remove (pool, buddy_idx);
+      if (buddy_idx < page_idx)
+        page_idx = buddy_idx;
+      order++;
+    }
+  block_insert (pool, page_idx, order);
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BLOCK_ERROR if no free block is big
+   enough. */
+static size_t
+range_alloc (struct pool *pool, size_t page_cnt)
+{
+  enum intr_level old_level;
+  size_t page_idx;
+  size_t i;
+  int order = 0;
+
+  while (((size_t) 1 << order) < page_cnt)
+    if (++order > MAX_ORDER)
+      return BLOCK_ERROR;
+
+  old_level = intr_disable ();
+  page_idx = block_alloc (pool, order);
+  if (page_idx != BLOCK_ERROR)
+    {
+      /* Give back the part of the block we don't need. */
+      pool->free_cnt -= (size_t) 1 << order;
+      range_free (pool, page_idx + page_cnt,
+                  ((size_t) 1 << order) - page_cnt);
+
+      for (i = 0; i < page_cnt; i++)
+        pool->state[page_idx + i] = PAGE_USED;
+    }
+  intr_set_level (old_level);
+  return page_idx;
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX to POOL, as
+   the largest aligned blocks that tile them.  The pages' states
+   must be 0.  Interrupts must be off, except during
+   initialization. */
+static void
+range_free (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  pool->free_cnt += page_cnt;
+  while (page_cnt > 0)
+    {
+      int order = 0;
+
+      while (order < MAX_ORDER
+             && (page_idx & ((size_t) 1 << order)) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      block_free (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
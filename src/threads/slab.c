@@ -0,0 +1,238 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator for objects of fixed size.
+
+   Each cache obtains single pages from the page allocator and
+   divides everything after a small header into objects of
+   exactly the cache's size (rounded up only for alignment).  A
+   slab's free objects are kept on a singly linked list threaded
+   through the objects themselves.
+
+   A cache keeps its slabs on two lists, those with free objects
+   and those without, so allocation never has to search.  When a
+   slab's last object is freed, the slab becomes the cache's
+   spare, or goes back to the page allocator if the cache already
+   has a spare.  Keeping one empty slab stops a cache that
+   hovers around a slab boundary from getting and freeing a page
+   on every other call.
+
+   A constructor, if the cache has one, is run on an object each
+   time it is handed out by slab_alloc(). */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* A slab: a page of objects, with this header at the start. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's slab lists. */
+    size_t used_cnt;            /* Number of objects in use. */
+    struct free_obj *free;      /* Free objects. */
+  };
+
+/* A free object. */
+struct free_obj
+  {
+    struct free_obj *next;      /* Next free object in the slab. */
+  };
+
+/* List of all caches, for statistics. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+static struct slab *slab_create (struct slab_cache *);
+static struct slab *obj_to_slab (struct slab_cache *, void *);
+
+/* Initializes cache C to hand out objects of OBJ_SIZE bytes,
+   naming it NAME for statistics.  If CTOR is nonnull, it is
+   called on each object that slab_alloc() returns.  Does not
+   allocate any memory, so it may be called before the page
+   allocator is initialized. */
+void
+slab_cache_init (struct slab_cache *c, const char *name, size_t obj_size,
+                 void (*ctor) (void *))
+{
+  if (obj_size < sizeof (struct free_obj))
+    obj_size = sizeof (struct free_obj);
+
+  c->name = name;
+  c->obj_size = ROUND_UP (obj_size, sizeof (void *));
+  c->objs_per_slab = (PGSIZE - sizeof (struct slab)) / c->obj_size;
+  ASSERT (c->objs_per_slab > 0);
+  c->ctor = ctor;
+  list_init (&c->partial);
+  list_init (&c->full);
+  c->spare = NULL;
+  lock_init (&c->lock);
+  c->slab_cnt = 0;
+  c->obj_cnt = 0;
+  list_push_back (&all_caches, &c->elem);
+}
+
+/* Obtains and returns a new object from cache C.
+   Returns a null pointer if memory is not available. */
+void *
+slab_alloc (struct slab_cache *c)
+{
+  struct slab *s;
+  struct free_obj *obj;
+
+  lock_acquire (&c->lock);
+
+  /* Find a slab with a free object, making one if necessary. */
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else
+    {
+      if (c->spare != NULL)
+        {
+          s = c->spare;
+          c->spare = NULL;
+        }
+      else
+        {
+          s = slab_create (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  /* Take the object, and retire the slab if that was its last. */
+  obj = s->free;
+  s->free = obj->next;
+  if (++s->used_cnt == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  c->obj_cnt++;
+
+  lock_release (&c->lock);
+
+  if (c->ctor != NULL)
+    c->ctor (obj);
+  return obj;
+}
+
+/* Returns OBJ, which must have been obtained from cache C with
+   slab_alloc(), to C.  Does nothing if OBJ is null. */
+void
+slab_free (struct slab_cache *c, void *obj_)
+{
+  struct free_obj *obj = obj_;
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs. */
+  memset (obj, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+
+  /* Put the object back, and move its slab off the full list. */
+  if (s->used_cnt-- == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  obj->next = s->free;
+  s->free = obj;
+  c->obj_cnt--;
+
+  /* Keep an empty slab as the spare or give it back. */
+  if (s->used_cnt == 0)
+    {
+      list_remove (&s->elem);
+      if (c->spare == NULL)
+        c->spare = s;
+      else
+        {
+          s->magic = 0;
+          palloc_free_page (s);
+          c->slab_cnt--;
+        }
+    }
+
+  lock_release (&c->lock);
+}
+
+/* Prints the occupancy of every cache. */
+void
+slab_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct slab_cache *c = list_entry (e, struct slab_cache, elem);
+
+      printf ("Slab cache %s: %zu of %zu objects in use, "
+              "%zu bytes each, %zu pages\n",
+              c->name, c->obj_cnt, c->slab_cnt * c->objs_per_slab,
+              c->obj_size, c->slab_cnt);
+    }
+}
+
+/* Obtains a page and sets it up as a slab of empty objects for
+   cache C.  Returns the new slab, or a null pointer if memory is
+   not available.  C's lock must be held. */
+static struct slab *
+slab_create (struct slab_cache *c)
+{
+  struct slab *s;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&c->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->used_cnt = 0;
+  s->free = NULL;
+  for (i = c->objs_per_slab; i-- > 0; )
+    {
+      struct free_obj *obj = (struct free_obj *) ((uint8_t *) (s + 1)
+                                                  + i * c->obj_size);
+      obj->next = s->free;
+      s->free = obj;
+    }
+  c->slab_cnt++;
+  return s;
+}
+
+/* Returns the slab that OBJ, an object of cache C, is inside. */
+static struct slab *
+obj_to_slab (struct slab_cache *c, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid and belongs to C. */
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT ((pg_ofs (obj) - sizeof *s) % c->obj_size == 0);
+
+  return s;
+}
@@ -0,0 +1,38 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+struct slab;
+
+/* A cache of fixed-size objects of one type.
+
+   Objects are carved out of whole pages ("slabs") at their exact
+   size, instead of being rounded up to a power of 2 as malloc()
+   does.  The members below the lock may be read, for accounting,
+   by anyone willing to tolerate a slightly stale value. */
+struct slab_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Size of each object in bytes. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    void (*ctor) (void *);      /* Initializes new objects, or null. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct list full;           /* Slabs with no objects free. */
+    struct slab *spare;         /* An empty slab kept in reserve. */
+    struct list_elem elem;      /* Element in list of all caches. */
+    struct lock lock;           /* Protects the members above. */
+
+    size_t slab_cnt;            /* Number of slabs (pages) held. */
+    size_t obj_cnt;             /* Number of objects in use. */
+  };
+
+void slab_cache_init (struct slab_cache *, const char *name,
+                      size_t obj_size, void (*ctor) (void *));
+void *slab_alloc (struct slab_cache *);
+void slab_free (struct slab_cache *, void *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -187,7 +187,7 @@ thread_create (const char *name, int priority,
   /* Miles driving */
   init_thread (t, name, priority);
   tid = t->tid = allocate_tid ();
-  struct child *my_child = (struct child *) malloc (sizeof (struct child));
+  struct child *my_child = slab_alloc (&child_cache);
   my_child->child_tid = t->tid;
   my_child->waited_on = 0;
   my_child->child_exit_code = 0;
@@ -299,6 +299,7 @@ thread_exit (void)
 #ifdef USERPROG
   process_exit ();
 #endif
+  malloc_drain_cache ();
 
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
@@ -412,6 +413,16 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Nothing else wants to run, so zero free pages ahead of
+         time for the page allocator, stopping as soon as a thread
+         becomes ready. */
+      intr_enable ();
+      while (list_empty (&ready_list) && palloc_zero_idle ())
+        continue;
+      intr_disable ();
+      if (!list_empty (&ready_list))
+        continue;
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -503,6 +514,17 @@ init_thread (struct thread *t, const char *name, int priority)
     t->parent = thread_current ();
   }
   /* Ryan end driving */
+#ifdef USERPROG
+  t->leader = t;
+  lock_init (&t->thread_lock);
+  list_init (&t->threads);
+  cond_init (&t->thread_ended);
+#endif
+#ifdef VM
+  lock_init (&t->pages_lock);
+  list_init (&t->mappings);
+  t->mapid_count = 0;
+#endif
   t->magic = THREAD_MAGIC;
   
   /* Miles driving */
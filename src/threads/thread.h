@@ -4,7 +4,11 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include "threads/malloc.h"
 #include "threads/synch.h"
+#ifdef VM
+#include <hash.h>
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -96,17 +100,20 @@ struct thread
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
 
+    /* Owned by threads/malloc.c. */
+    struct malloc_cache malloc_caches[MALLOC_DESC_CNT]; /* Free blocks. */
+
     /** PROJECT 2: USER PROGRAMS **/
 
-    /* Brian Driving */
-    /* list of open files */
-    struct list file_list;
-    struct file *executable;
-    /* End Driving */
+    /* A user process is one or more threads sharing an address
+       space and open files.  The thread that started running the
+       program, the process's leader, keeps the per-process state
+       further below for the whole process and outlives its other
+       threads, which reach that state through `leader'.  The
+       members here are each thread's own. */
+
     /* Sam Driving */
-    /* used for when a process exits */
-    int exit_code;
-    /* list of all this process's children, child struct defined in process.h */
+    /* list of all this thread's children, child struct defined in process.h */
     struct list child_list;
     /* synchronize access to child list */
     struct lock child_list_lock;
@@ -124,13 +131,49 @@ struct thread
     struct semaphore child_sema;
     /* locks when exiting a call to exit */
     struct semaphore exit_sema;
+    /* End Sam Driving */
+
+#ifdef USERPROG
+    /* Owned by userprog/process.c. */
+    uint32_t *pagedir;                  /* Page directory, the leader's. */
+    struct thread *leader;              /* Leader of this thread's process. */
+    struct user_thread *user_thread;    /* Record of a non-leader thread. */
+#endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    void *user_esp;                     /* User esp on syscall entry. */
+#endif
+
+    /* Per-process state, used only in a process's leader. */
+
+    /* Brian Driving */
+    /* list of open files */
+    struct list file_list;
+    struct file *executable;
+    /* End Driving */
+    /* Sam Driving */
+    /* used for when a process exits */
+    int exit_code;
     /* keep track of fd count */
     int fd_count;
     /* End Sam Driving */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
-    uint32_t *pagedir;                  /* Page directory. */
+    struct lock thread_lock;            /* Protects the members below. */
+    struct list threads;                /* Threads not yet joined. */
+    int thread_cnt;                     /* Threads other than the leader. */
+    struct condition thread_ended;      /* Signaled when one ends. */
+    bool exiting;                       /* True once exit() is called. */
+#endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash pages;                  /* Supplemental page table. */
+    struct lock pages_lock;             /* Serializes use of `pages'. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int mapid_count;                    /* Next mapping identifier. */
 #endif
   
     /* Owned by thread.c. */
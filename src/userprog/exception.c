@@ -2,8 +2,14 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -85,11 +91,12 @@ kill (struct intr_frame *f)
     {
     case SEL_UCSEG:
       /* User's code segment, so it's a user exception, as we
-         expected.  Kill the user process.  */
+         expected.  Kill the user process, with all of its
+         threads.  */
       printf ("%s: dying due to interrupt %#04x (%s).\n",
               thread_name (), f->vec_no, intr_name (f->vec_no));
       intr_dump_frame (f);
-      thread_exit (); 
+      process_terminate (-1); 
 
     case SEL_KCSEG:
       /* Kernel's code segment, which indicates a kernel bug.
@@ -148,9 +155,28 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  /* To implement virtual memory, delete the rest of the function
-     body, and replace it with code that brings in the page to
-     which fault_addr refers. */
+#ifdef VM
+  /* A not-present fault on a user address may just be a page
+     that hasn't been brought in yet, or the stack growing, and a
+     write to a read-only page may hit a page shared copy-on-write
+     since fork().  This also covers the kernel touching a user
+     buffer during a system call, in which case f->esp is the
+     kernel's stack pointer and the user's must be taken from the
+     system call entry. */
+  if ((not_present || write) && is_user_vaddr (fault_addr)
+      && page_fault_in (fault_addr,
+                        user ? f->esp : thread_current ()->user_esp,
+                        write))
+    return;
+#endif
+
+  /* A fault by the kernel on a user address that can't be
+     satisfied is a bad pointer passed in a system call, which
+     the function accessing it reports to its caller. */
+  if (!user && is_user_vaddr (fault_addr) && uaccess_fixup (f))
+    return;
+
+  /* Anything else is a genuine fault. */
   printf ("Page fault at %p: %s error %s page in %s context.\n",
           fault_addr,
           not_present ? "not present" : "rights violation",
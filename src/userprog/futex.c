@@ -0,0 +1,209 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+
+/* Futexes ("fast user-space mutexes").
+
+   A user program builds locks and the like out of ordinary words
+   of its own memory, which it updates with atomic instructions,
+   and asks the kernel for help only to sleep when a word shows
+   that it must wait, or to wake sleepers after changing a word.
+   The uncontended case never enters the kernel.
+
+   Sleepers are queued under the physical address of the word
+   they wait on, so that every mapping of the same memory finds
+   the same queue.  The caller keeps the frame holding the word
+   resident for as long as it uses the kernel address, which
+   keeps that physical address meaningful. */
+
+/* Threads waiting on one word. */
+struct futex_queue
+  {
+    uintptr_t paddr;            /* Physical address of the word. */
+    struct list waiters;        /* List of struct futex_waiter. */
+    struct hash_elem elem;      /* Element in FUTEX_QUEUES. */
+  };
+
+/* A thread sleeping in futex_wait(). */
+struct futex_waiter
+  {
+    struct thread *leader;      /* Leader of the thread's process. */
+    struct semaphore sema;      /* Upped to wake the thread. */
+    struct list_elem elem;      /* Element in a futex_queue. */
+  };
+
+/* Queues with at least one waiter, keyed by physical address. */
+static struct hash futex_queues;
+
+/* Protects FUTEX_QUEUES and every queue in it.  Holding it across
+   the check of the word in futex_wait() keeps a wakeup from
+   slipping in between the check and the sleep. */
+static struct lock futex_lock;
+
+static hash_hash_func queue_hash;
+static hash_less_func queue_less;
+static struct futex_queue *queue_find (uintptr_t paddr);
+
+/* Initializes the futex module. */
+void
+futex_init (void)
+{
+  hash_init (&futex_queues, queue_hash, queue_less, NULL);
+  lock_init (&futex_lock);
+}
+
+/* Sleeps until woken by futex_wake() on the word at kernel
+   address KADDR, if that word is EXPECTED.  Returns true if the
+   thread slept and was woken, false if the word held some other
+   value, the process is exiting or memory is short. */
+bool
+futex_wait (const int *kaddr, int expected)
+{
+  uintptr_t paddr = vtop (kaddr);
+  struct futex_waiter w;
+  struct futex_queue *q;
+
+  lock_acquire (&futex_lock);
+  if (*(volatile const int *) kaddr != expected
+      || process_current ()->exiting)
+    {
+      lock_release (&futex_lock);
+      return false;
+    }
+
+  q = queue_find (paddr);
+  if (q == NULL)
+    {
+      q = malloc (sizeof *q);
+      if (q == NULL)
+        {
+          lock_release (&futex_lock);
+          return false;
+        }
+      q->paddr = paddr;
+      list_init (&q->waiters);
+      hash_insert (&futex_queues, &q->elem);
+    }
+  w.leader = process_current ();
+  sema_init (&w.sema, 0);
+  list_push_back (&q->waiters, &w.elem);
+  lock_release (&futex_lock);
+
+  sema_down (&w.sema);
+  return true;
+}
+
+/* Wakes up to CNT threads waiting on the word at kernel address
+   KADDR, in the order they began waiting.  Returns the number
+   woken. */
+int
+futex_wake (const int *kaddr, int cnt)
+{
+  struct futex_queue *q;
+  int woken = 0;
+
+  lock_acquire (&futex_lock);
+  q = queue_find (vtop (kaddr));
+  if (q != NULL)
+    {
+      while (woken < cnt && !list_empty (&q->waiters))
+        {
+          struct list_elem *e = list_pop_front (&q->waiters);
+          sema_up (&list_entry (e, struct futex_waiter, elem)->sema);
+          woken++;
+        }
+      if (list_empty (&q->waiters))
+        {
+          hash_delete (&futex_queues, &q->elem);
+          free (q);
+        }
+    }
+  lock_release (&futex_lock);
+  return woken;
+}
+
+/* Wakes every thread of the process led by LEADER that is
+   sleeping in futex_wait(), so that it can notice that the process
+   is exiting.  futex_wait() checks for that under futex_lock, so
+   none can go to sleep after this. */
+void
+futex_wake_process (struct thread *leader)
+{
+  struct hash_iterator i;
+  bool restart;
+
+  lock_acquire (&futex_lock);
+  do
+    {
+      restart = false;
+      hash_first (&i, &futex_queues);
+      while (!restart && hash_next (&i))
+        {
+          struct futex_queue *q = hash_entry (hash_cur (&i),
+                                              struct futex_queue, elem);
+          struct list_elem *e = list_begin (&q->waiters);
+
+          while (e != list_end (&q->waiters))
+            {
+              struct futex_waiter *w = list_entry (e, struct futex_waiter,
+                                                   elem);
+              e = list_next (e);
+              if (w->leader == leader)
+                {
+                  list_remove (&w->elem);
+                  sema_up (&w->sema);
+                }
+            }
+
+          /* Deleting from the table ends the iteration. */
+          if (list_empty (&q->waiters))
+            {
+              hash_delete (&futex_queues, &q->elem);
+              free (q);
+              restart = true;
+            }
+        }
+    }
+  while (restart);
+  lock_release (&futex_lock);
+}
+
+/* Returns the queue for the word at physical address PADDR, or a
+   null pointer if nothing waits on it.  The caller must hold
+   futex_lock. */
+static struct futex_queue *
+queue_find (uintptr_t paddr)
+{
+  struct futex_queue key;
+  struct hash_elem *e;
+
+  key.paddr = paddr;
+  e = hash_find (&futex_queues, &key.elem);
+  return e != NULL ? hash_entry (e, struct futex_queue, elem) : NULL;
+}
+
+/* Returns a hash value for the futex queue that E refers to. */
+static unsigned
+queue_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct futex_queue *q = hash_entry (e, struct futex_queue, elem);
+  return hash_int (q->paddr);
+}
+
+/* Returns true if futex queue A precedes futex queue B. */
+static bool
+queue_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct futex_queue *a = hash_entry (a_, struct futex_queue, elem);
+  const struct futex_queue *b = hash_entry (b_, struct futex_queue, elem);
+
+  return a->paddr < b->paddr;
+}
@@ -0,0 +1,214 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <list.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+
+/* Pipes.
+
+   A pipe carries bytes from the processes holding its write end
+   to the processes holding its read end through a ring buffer of
+   one page, without touching the file system.  Data is copied in
+   at most two blocks per call, one on each side of the point
+   where the ring wraps.
+
+   A reader blocks until some data is available and then takes as
+   much as it can, up to what it asked for; once every write end
+   is closed and the buffer is empty, it reads end of file.  A
+   writer blocks while the buffer is full and returns only when
+   all of its data has been written, unless every read end is
+   closed, in which case nothing more can be written.  Either
+   stops waiting early once the process it belongs to is ending,
+   as pipe_wake_all() tells it to check. */
+
+/* Size of a pipe's buffer. */
+#define PIPE_SIZE PGSIZE
+
+/* A pipe. */
+struct pipe
+  {
+    struct lock lock;           /* Protects the members below. */
+    struct condition not_empty; /* Signaled when data or EOF arrives. */
+    struct condition not_full;  /* Signaled when room or EPIPE arrives. */
+    uint8_t *buf;               /* PIPE_SIZE bytes of data. */
+    size_t head;                /* Offset of the first byte in BUF. */
+    size_t used;                /* Number of bytes in BUF. */
+    int readers;                /* Number of open read ends. */
+    int writers;                /* Number of open write ends. */
+    struct list_elem elem;      /* Element in ALL_PIPES. */
+  };
+
+/* Every pipe that exists, protected by PIPES_LOCK, which is
+   acquired before any pipe's own lock. */
+static struct list all_pipes;
+static struct lock pipes_lock;
+
+/* Initializes the pipe module. */
+void
+pipe_init (void)
+{
+  list_init (&all_pipes);
+  lock_init (&pipes_lock);
+}
+
+/* Creates a new, empty pipe with one read end and one write end
+   open.  Returns the pipe, or a null pointer if memory is
+   short. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  lock_init (&p->lock);
+  cond_init (&p->not_empty);
+  cond_init (&p->not_full);
+  p->head = p->used = 0;
+  p->readers = p->writers = 1;
+  lock_acquire (&pipes_lock);
+  list_push_back (&all_pipes, &p->elem);
+  lock_release (&pipes_lock);
+  return p;
+}
+
+/* Opens another read end of P, or write end if WRITER is true. */
+void
+pipe_dup (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release (&p->lock);
+}
+
+/* Closes a read end of P, or write end if WRITER is true.  Wakes
+   anyone waiting for the other end when this was its last
+   counterpart, and frees P when no ends remain open. */
+void
+pipe_close (struct pipe *p, bool writer)
+{
+  bool destroy;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    {
+      ASSERT (p->writers > 0);
+      if (--p->writers == 0)
+        cond_broadcast (&p->not_empty, &p->lock);
+    }
+  else
+    {
+      ASSERT (p->readers > 0);
+      if (--p->readers == 0)
+        cond_broadcast (&p->not_full, &p->lock);
+    }
+  destroy = p->readers == 0 && p->writers == 0;
+  lock_release (&p->lock);
+
+  if (destroy)
+    {
+      lock_acquire (&pipes_lock);
+      list_remove (&p->elem);
+      lock_release (&pipes_lock);
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
+
+/* Reads up to SIZE bytes from P into BUF, waiting for data if P
+   is empty.  Returns the number of bytes read, which is 0 only
+   at end of file, if SIZE is 0, or if the running process is
+   ending. */
+int
+pipe_read (struct pipe *p, void *buf_, size_t size)
+{
+  uint8_t *buf = buf_;
+  size_t cnt, first;
+
+  lock_acquire (&p->lock);
+  while (p->used == 0 && p->writers > 0 && size > 0
+         && !process_current ()->exiting)
+    cond_wait (&p->not_empty, &p->lock);
+
+  cnt = size < p->used ? size : p->used;
+  first = PIPE_SIZE - p->head < cnt ? PIPE_SIZE - p->head : cnt;
+  memcpy (buf, p->buf + p->head, first);
+  memcpy (buf + first, p->buf, cnt - first);
+  p->head = (p->head + cnt) % PIPE_SIZE;
+  p->used -= cnt;
+  if (cnt > 0)
+    cond_broadcast (&p->not_full, &p->lock);
+  lock_release (&p->lock);
+
+  return cnt;
+}
+
+/* Writes the SIZE bytes in BUF to P, waiting for room as needed.
+   Returns the number of bytes written, which is less than SIZE
+   only if every read end of P is closed or the running process
+   is ending, or -1 if none could be written for either reason. */
+int
+pipe_write (struct pipe *p, const void *buf_, size_t size)
+{
+  const uint8_t *buf = buf_;
+  size_t written = 0;
+
+  lock_acquire (&p->lock);
+  while (written < size)
+    {
+      size_t tail, cnt, first;
+
+      while (p->used == PIPE_SIZE && p->readers > 0
+             && !process_current ()->exiting)
+        cond_wait (&p->not_full, &p->lock);
+      if (p->readers == 0 || p->used == PIPE_SIZE)
+        break;
+
+      tail = (p->head + p->used) % PIPE_SIZE;
+      cnt = size - written < PIPE_SIZE - p->used
+            ? size - written : PIPE_SIZE - p->used;
+      first = PIPE_SIZE - tail < cnt ? PIPE_SIZE - tail : cnt;
+      memcpy (p->buf + tail, buf + written, first);
+      memcpy (p->buf, buf + written + first, cnt - first);
+      p->used += cnt;
+      written += cnt;
+      cond_broadcast (&p->not_empty, &p->lock);
+    }
+  lock_release (&p->lock);
+
+  return written > 0 || size == 0 ? (int) written : -1;
+}
+
+/* Wakes every thread waiting to read or write any pipe, so that
+   those of a process that is ending notice and return.  The rest
+   go back to waiting. */
+void
+pipe_wake_all (void)
+{
+  struct list_elem *e;
+
+  lock_acquire (&pipes_lock);
+  for (e = list_begin (&all_pipes); e != list_end (&all_pipes);
+       e = list_next (e))
+    {
+      struct pipe *p = list_entry (e, struct pipe, elem);
+
+      lock_acquire (&p->lock);
+      cond_broadcast (&p->not_empty, &p->lock);
+      cond_broadcast (&p->not_full, &p->lock);
+      lock_release (&p->lock);
+    }
+  lock_release (&pipes_lock);
+}
@@ -0,0 +1,17 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct pipe;
+
+void pipe_init (void);
+struct pipe *pipe_create (void);
+void pipe_dup (struct pipe *, bool writer);
+void pipe_close (struct pipe *, bool writer);
+int pipe_read (struct pipe *, void *buf, size_t size);
+int pipe_write (struct pipe *, const void *buf, size_t size);
+void pipe_wake_all (void);
+
+#endif /* userprog/pipe.h */
@@ -8,6 +8,7 @@
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
+#include "devices/input.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
@@ -19,9 +20,27 @@
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include "userprog/futex.h"
+#include "userprog/pipe.h"
 #include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 static thread_func start_process NO_RETURN;
+static bool inherit_std_fds (struct thread *parent);
+#ifdef VM
+static thread_func fork_process NO_RETURN;
+static bool fork_files (struct thread *parent);
+static bool fork_address_space (struct thread *parent);
+#endif
+static thread_func start_thread NO_RETURN;
+static void close_files (struct thread *);
+static void end_thread (struct thread *);
+static void wait_for_threads (struct thread *leader);
 static bool load (char *argv[], int argc, void (**eip) (void), void **esp);
 
 
@@ -35,6 +54,15 @@ struct args
 };
 /* Sam end Driving */
 
+struct slab_cache child_cache;
+
+/* Initializes the process module. */
+void
+process_init (void)
+{
+  slab_cache_init (&child_cache, "child", sizeof (struct child), NULL);
+}
+
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
    before process_execute() returns.  Returns the new process's
@@ -124,6 +152,8 @@ start_process (void *file_name_)
   /* now arg_vector contains the argument vector */
   /* load the exe and get the status */
   success = load (arg_vector, argc, &if_.eip, &if_.esp);
+  if (success)
+    success = inherit_std_fds (thread_current ()->parent);
   
   /* If load failed, quit. */
   palloc_free_page (file_name);
@@ -157,6 +187,376 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Creates a child of the current process that is a copy of it,
+   resuming in user mode from the system call whose interrupt
+   frame is PARENT_IF.  The child gets a duplicate of each open
+   file descriptor, sharing its position with the parent's, and
+   shares the parent's memory copy-on-write;
+   memory-mapped files are not inherited.  Returns the child's
+   thread id in the parent, 0 in the child, or TID_ERROR if the
+   child could not be created. */
+tid_t
+process_fork (struct intr_frame *parent_if)
+{
+  struct thread *cur = thread_current ();
+  tid_t tid;
+
+  tid = thread_create (cur->name, PRI_DEFAULT, fork_process, parent_if);
+  if (tid == TID_ERROR)
+    return TID_ERROR;
+
+  /* wait for the child to finish copying us */
+  sema_down (&cur->child_sema);
+  return cur->load_success ? tid : TID_ERROR;
+}
+
+/* A thread function that copies the parent process of the
+   running thread, which is blocked in process_fork(), and starts
+   it running where the parent left off. */
+static void
+fork_process (void *parent_if_)
+{
+  struct thread *child = thread_current ();
+  struct thread *parent = child->parent;
+  struct intr_frame if_;
+  bool success;
+
+  /* The parent's interrupt frame stays on its kernel stack until
+     we let it go. */
+  memcpy (&if_, parent_if_, sizeof if_);
+  if_.eax = 0;
+
+  success = (fork_files (parent->leader)
+             && fork_address_space (parent->leader));
+  parent->load_success = success;
+  sema_up (&parent->child_sema);
+  if (!success)
+    thread_exit ();
+
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Gives the running thread its own handles on PARENT's executable
+   and open files and pipe ends, with the same descriptors and
+   positions.
+   Returns true if successful, false if memory is short; whatever
+   was opened is closed when the thread exits. */
+static bool
+fork_files (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+  bool success = true;
+
+  lock_acquire (&file_sys_lock);
+  if (parent->executable != NULL)
+    {
+      t->executable = file_reopen (parent->executable);
+      if (t->executable != NULL)
+        file_deny_write (t->executable);
+      else
+        success = false;
+    }
+  for (e = list_begin (&parent->file_list);
+       success && e != list_end (&parent->file_list); e = list_next (e))
+    {
+      struct file_elem *pf = list_entry (e, struct file_elem, elem);
+      struct file_elem *cf = dup_file (pf, pf->fd);
+
+      if (cf != NULL)
+        list_push_back (&t->file_list, &cf->elem);
+      else
+        success = false;
+    }
+  t->fd_count = parent->fd_count;
+  lock_release (&file_sys_lock);
+  return success;
+}
+
+/* Gives the running thread a page directory and page table that
+   share PARENT's memory copy-on-write.  Returns true if
+   successful, false if memory is short. */
+static bool
+fork_address_space (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    return false;
+  if (!page_table_init (&t->pages))
+    {
+      pagedir_destroy (t->pagedir);
+      t->pagedir = NULL;
+      return false;
+    }
+  process_activate ();
+  return page_table_copy (parent);
+}
+#endif
+
+/* Returns the leader of the running thread's process, the thread
+   that holds the process's open files, address space and other
+   per-process state.  A thread that is not part of a multithreaded
+   process is its own leader. */
+struct thread *
+process_current (void)
+{
+  return thread_current ()->leader;
+}
+
+/* What a new thread of a user process needs to get going. */
+struct spawn_info
+  {
+    struct thread *leader;      /* Leader of the process to join. */
+    struct user_thread *ut;     /* The new thread's record. */
+    void (*eip) (void);         /* Where to start running. */
+    void *esp;                  /* Initial user stack pointer. */
+  };
+
+/* Starts a new thread in the running process, sharing its address
+   space and open files, that calls ENTRY(ARG) on the user stack
+   that ends just below STACK.  ENTRY must not return, since it has
+   nowhere to return to.  Returns the new thread's identifier, or
+   TID_ERROR if the stack cannot be written, the process is exiting
+   or memory is short. */
+tid_t
+process_spawn_thread (void *entry, void *arg, void *stack)
+{
+  struct thread *cur = thread_current ();
+  struct thread *leader = cur->leader;
+  struct spawn_info *info;
+  struct user_thread *ut;
+  struct child *c;
+  void *frame[2];
+  tid_t tid;
+
+  /* Lay out a call to ENTRY with a null return address. */
+  frame[0] = NULL;
+  frame[1] = arg;
+  if (!copy_to_user ((void **) stack - 2, frame, sizeof frame))
+    return TID_ERROR;
+
+  info = malloc (sizeof *info);
+  ut = malloc (sizeof *ut);
+  if (info == NULL || ut == NULL)
+    {
+      free (info);
+      free (ut);
+      return TID_ERROR;
+    }
+  info->leader = leader;
+  info->ut = ut;
+  info->eip = (void (*) (void)) entry;
+  info->esp = (void **) stack - 2;
+  ut->tid = TID_ERROR;
+  ut->ended = ut->joining = false;
+
+  /* Count the thread before it exists, so that the leader cannot
+     finish exiting while it starts. */
+  lock_acquire (&leader->thread_lock);
+  if (leader->exiting)
+    {
+      lock_release (&leader->thread_lock);
+      free (info);
+      free (ut);
+      return TID_ERROR;
+    }
+  leader->thread_cnt++;
+  list_push_back (&leader->threads, &ut->elem);
+  lock_release (&leader->thread_lock);
+
+  tid = thread_create (leader->name, PRI_DEFAULT, start_thread, info);
+
+  lock_acquire (&leader->thread_lock);
+  if (tid != TID_ERROR)
+    ut->tid = tid;
+  else
+    {
+      list_remove (&ut->elem);
+      leader->thread_cnt--;
+      cond_broadcast (&leader->thread_ended, &leader->thread_lock);
+      free (info);
+      free (ut);
+    }
+  lock_release (&leader->thread_lock);
+
+  /* thread_create() made the new thread our child, but it is not
+     a process that wait() should see. */
+  c = get_child (tid, cur);
+  if (c != NULL)
+    {
+      lock_acquire (&cur->child_list_lock);
+      list_remove (&c->child_elem);
+      lock_release (&cur->child_list_lock);
+      slab_free (&child_cache, c);
+    }
+  return tid;
+}
+
+/* A thread function that joins the running thread to the process
+   described by INFO_ and starts it running in user mode. */
+static void
+start_thread (void *info_)
+{
+  struct spawn_info *info = info_;
+  struct thread *t = thread_current ();
+  struct intr_frame if_;
+
+  t->leader = info->leader;
+  t->user_thread = info->ut;
+  t->pagedir = info->leader->pagedir;
+  t->parent = NULL;
+
+  memset (&if_, 0, sizeof if_);
+  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.cs = SEL_UCSEG;
+  if_.eflags = FLAG_IF | FLAG_MBS;
+  if_.eip = info->eip;
+  if_.esp = info->esp;
+  free (info);
+  process_activate ();
+
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Waits for thread TID of the running process to end.  Returns
+   true if successful, false if TID is not a thread of the process
+   other than its leader and the running thread, or another thread
+   has already joined it or begun to. */
+bool
+process_join_thread (tid_t tid)
+{
+  struct thread *leader = process_current ();
+  struct user_thread *ut = NULL;
+  struct list_elem *e;
+
+  lock_acquire (&leader->thread_lock);
+  for (e = list_begin (&leader->threads); e != list_end (&leader->threads);
+       e = list_next (e))
+    {
+      struct user_thread *u = list_entry (e, struct user_thread, elem);
+      if (u->tid == tid)
+        {
+          ut = u;
+          break;
+        }
+    }
+  if (ut == NULL || ut->joining || ut == thread_current ()->user_thread)
+    {
+      lock_release (&leader->thread_lock);
+      return false;
+    }
+
+  ut->joining = true;
+  while (!ut->ended)
+    cond_wait (&leader->thread_ended, &leader->thread_lock);
+  list_remove (&ut->elem);
+  lock_release (&leader->thread_lock);
+  free (ut);
+  return true;
+}
+
+/* Ends the running thread.  The process ends when its last thread
+   does; if no thread has called exit() by then, its exit status is
+   0. */
+void
+process_exit_thread (void)
+{
+  struct thread *leader = process_current ();
+
+  lock_acquire (&leader->thread_lock);
+  if (!leader->exiting)
+    leader->exit_code = 0;
+  lock_release (&leader->thread_lock);
+  thread_exit ();
+}
+
+/* Ends the running process with exit status STATUS, unless it is
+   already ending, in which case its status stays as it was.  Each
+   of the process's other threads ends the next time it enters the
+   kernel or returns to user mode, which a running thread does at
+   its next timer interrupt at the latest; any sleeping in
+   futex_wait(), on a pipe or on the keyboard are woken to do so.
+   The process's descriptors are closed at once, since a thread
+   in wait() may be waiting for a child that reads a pipe only
+   this process writes.  The leader finishes the process once all
+   of the other threads are gone. */
+void
+process_terminate (int status)
+{
+  struct thread *leader = process_current ();
+  bool wake = false;
+
+  lock_acquire (&leader->thread_lock);
+  if (!leader->exiting)
+    {
+      leader->exiting = true;
+      leader->exit_code = status;
+      wake = leader->thread_cnt > 0;
+    }
+  lock_release (&leader->thread_lock);
+  if (wake)
+    {
+      futex_wake_process (leader);
+      pipe_wake_all ();
+      input_wake ();
+      close_files (leader);
+    }
+  thread_exit ();
+}
+
+/* Ends the running thread if its process is ending.  Called just
+   before each return to user mode. */
+void
+process_check_exiting (void)
+{
+  if (process_current ()->exiting)
+    {
+      intr_enable ();
+      thread_exit ();
+    }
+}
+
+/* Finishes T, a thread of a user process other than its leader,
+   as it exits, and tells the rest of the process. */
+static void
+end_thread (struct thread *t)
+{
+  struct thread *leader = t->leader;
+
+  free_resources (t);
+
+  /* Let go of the page directory before the leader may destroy
+     it. */
+  t->pagedir = NULL;
+  pagedir_activate (NULL);
+
+  lock_acquire (&leader->thread_lock);
+  t->user_thread->ended = true;
+  leader->thread_cnt--;
+  cond_broadcast (&leader->thread_ended, &leader->thread_lock);
+  lock_release (&leader->thread_lock);
+}
+
+/* Waits until LEADER, which must be the running thread, is the
+   last thread left in its process, then frees the records of the
+   threads that no one joined. */
+static void
+wait_for_threads (struct thread *leader)
+{
+  lock_acquire (&leader->thread_lock);
+  while (leader->thread_cnt > 0)
+    cond_wait (&leader->thread_ended, &leader->thread_lock);
+  while (!list_empty (&leader->threads))
+    free (list_entry (list_pop_front (&leader->threads),
+                      struct user_thread, elem));
+  lock_release (&leader->thread_lock);
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -253,6 +653,82 @@ get_file (struct list* files, int fd)
   return NULL;
 }
 
+/* Returns a new descriptor FD for whatever F refers to, or a
+   null pointer if memory is short.  The two share the pipe end
+   or the open file, including its position, as dup2() and
+   fork() do in Unix.  The caller must hold file_sys_lock. */
+struct file_elem *
+dup_file (struct file_elem *f, int fd)
+{
+  struct file_elem *d = slab_alloc (&file_elem_cache);
+  if (d == NULL)
+    return NULL;
+  d->fd = fd;
+  d->file = NULL;
+  d->pipe = f->pipe;
+  d->pipe_writer = f->pipe_writer;
+  if (f->pipe != NULL)
+    pipe_dup (f->pipe, f->pipe_writer);
+  else
+    d->file = file_dup (f->file);
+  return d;
+}
+
+/* Closes the file or pipe end that F refers to and frees F, which
+   must already be out of its list.  The caller must hold
+   file_sys_lock. */
+void
+close_file (struct file_elem *f)
+{
+  if (f->pipe != NULL)
+    pipe_close (f->pipe, f->pipe_writer);
+  else
+    file_close (f->file);
+  slab_free (&file_elem_cache, f);
+}
+
+/* Closes every file and pipe end that T has open. */
+static void
+close_files (struct thread *t)
+{
+  lock_acquire (&file_sys_lock);
+  while (!list_empty (&t->file_list))
+    close_file (list_entry (list_pop_back (&t->file_list),
+                            struct file_elem, elem));
+  lock_release (&file_sys_lock);
+}
+
+/* Gives the running thread duplicates of PARENT's standard input
+   and output, if PARENT has redirected them, so that a pipeline
+   set up by PARENT reaches the new process.  Other descriptors
+   are not inherited: a child holding a stray end of a pipe could
+   keep it open forever.  Returns true if successful, false if
+   memory is short. */
+static bool
+inherit_std_fds (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  bool success = true;
+  int fd;
+
+  lock_acquire (&file_sys_lock);
+  for (fd = STDIN_FILENO; success && fd <= STDOUT_FILENO; fd++)
+    {
+      struct file_elem *pf = get_file (&parent->leader->file_list, fd);
+      struct file_elem *cf;
+
+      if (pf == NULL)
+        continue;
+      cf = dup_file (pf, fd);
+      if (cf != NULL)
+        list_push_back (&t->file_list, &cf->elem);
+      else
+        success = false;
+    }
+  lock_release (&file_sys_lock);
+  return success;
+}
+
 
 void 
 free_resources (struct thread *t)
@@ -265,25 +741,17 @@ free_resources (struct thread *t)
   }
   
   struct list_elem *iterator = NULL;
-  struct file_elem *cur_file = NULL;
   struct child *cur_child = NULL;
 
   /* synchronize and free the memory we don't need */
-  lock_acquire (&file_sys_lock);
-  while (!list_empty (&t->file_list))
-  {
-    iterator = list_pop_back (&t->file_list);
-    cur_file = list_entry (iterator, struct file_elem, elem);
-    file_close (cur_file->file);
-  }    
-  lock_release (&file_sys_lock);
+  close_files (t);
 
   lock_acquire (&t->child_list_lock);
   while (!list_empty (&t->child_list))
   {
     iterator = list_pop_back (&t->child_list);
     cur_child = list_entry (iterator, struct child, child_elem);
-    free (cur_child);
+    slab_free (&child_cache, cur_child);
   }
   lock_release (&t->child_list_lock);
 
@@ -301,6 +769,15 @@ process_exit (void)
   uint32_t *pd;
   bool be_reaped = false;
 
+  /* A thread other than the leader leaves the process's state to
+     the leader, which goes last. */
+  if (cur_thread->user_thread != NULL)
+    {
+      end_thread (cur_thread);
+      return;
+    }
+  wait_for_threads (cur_thread);
+
   /* Brian driving */
   /* save reference to parent */
   struct thread *parent = cur_thread->parent;
@@ -333,6 +810,18 @@ process_exit (void)
   if (be_reaped)
     sema_up (&cur_thread->parent->reap_sema);
 
+#ifdef VM
+  /* Release the process's frames while its page directory is
+     still in place, since the eviction code may be looking at
+     it, and before closing the executable, whose inode keys
+     any text frames shared with other processes. */
+  if (cur_thread->pagedir != NULL)
+    {
+      mmap_unmap_all ();
+      page_table_destroy (&cur_thread->pages);
+    }
+#endif
+
   /* close the executable file */
   if (cur_thread->executable != NULL)
     file_close (cur_thread->executable);
@@ -470,6 +959,14 @@ load (char *argv[], int argc, void (**eip) (void), void **esp)
   {
     goto done;
   } 
+#ifdef VM
+  if (!page_table_init (&t->pages))
+  {
+    pagedir_destroy (t->pagedir);
+    t->pagedir = NULL;
+    goto done;
+  }
+#endif
   process_activate ();
 
 
@@ -591,7 +1088,9 @@ load (char *argv[], int argc, void (**eip) (void), void **esp)
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -660,6 +1159,31 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifdef VM
+  /* Only record where each page comes from.  The page fault
+     handler reads it in the first time the process touches it. */
+  while (read_bytes > 0 || zero_bytes > 0) 
+    {
+      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+      struct page *p;
+
+      if (page_read_bytes > 0)
+        p = page_add_file (upage, file, ofs, page_read_bytes,
+                           page_zero_bytes, writable);
+      else
+        p = page_add_zero (upage, writable);
+      if (p == NULL)
+        return false;
+
+      /* Advance. */
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
+      upage += PGSIZE;
+    }
+  return true;
+#else
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -695,6 +1219,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       upage += PGSIZE;
     }
   return true;
+#endif
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -705,10 +1230,21 @@ setup_stack (char *argv[], int argc, void **esp)
   uint8_t *kpage;
   bool success = false;
 
+#ifdef VM
+  /* The arguments are written right away, so load the first
+     stack page now rather than waiting for it to fault in. */
+  struct page *p = page_add_zero (((uint8_t *) PHYS_BASE) - PGSIZE, true);
+  kpage = p != NULL && page_load (p) ? p->frame->kpage : NULL;
+#else
   kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+#endif
   if (kpage != NULL) 
     {
+#ifdef VM
+      success = true;
+#else
       success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
+#endif
       if (success)
       {
         /* Sam driving */
@@ -725,13 +1261,8 @@ setup_stack (char *argv[], int argc, void **esp)
             /* count number of bytes needed */
             count += strlen (argv[i]) + 1;
             /* check for page size */
-<<<<<<< HEAD
             if (count > PGSIZE)
               return false;
-=======
-             if (count > PGSIZE)
-               return false;
->>>>>>> dd528bab2ad8372ac04de102e1e6e33a49403cef
       
             /* add the arg addresses to an array */
             esp_cpy -= strlen (argv[i]) + 1;
@@ -752,13 +1283,8 @@ setup_stack (char *argv[], int argc, void **esp)
         }
 
         /* check size again */
-<<<<<<< HEAD
         if (count > PGSIZE)
           return false;
-=======
-         if (count > PGSIZE)
-              return false;
->>>>>>> dd528bab2ad8372ac04de102e1e6e33a49403cef
 
         /* sentinel */
         esp_cpy -= sizeof (char *);
@@ -787,8 +1313,10 @@ setup_stack (char *argv[], int argc, void **esp)
         *esp = esp_cpy;
         /* End Sam driving */
       }
+#ifndef VM
       else
         palloc_free_page (kpage);
+#endif
     }
  
   return success;
@@ -804,6 +1332,7 @@ setup_stack (char *argv[], int argc, void **esp)
    with palloc_get_page().
    Returns true on success, false if UPAGE is already mapped or
    if memory allocation fails. */
+#ifndef VM
 static bool
 install_page (void *upage, void *kpage, bool writable)
 {
@@ -814,3 +1343,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -1,16 +1,30 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include "threads/slab.h"
 #include "threads/thread.h"
 
+void process_init (void);
 tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+#ifdef VM
+struct intr_frame;
+tid_t process_fork (struct intr_frame *);
+#endif
+struct thread *process_current (void);
+tid_t process_spawn_thread (void *entry, void *arg, void *stack);
+bool process_join_thread (tid_t);
+void process_exit_thread (void) NO_RETURN;
+void process_terminate (int status) NO_RETURN;
+void process_check_exiting (void);
 
 /* exit and wait helper functions */
 struct child* get_child (tid_t tid, struct thread *cur_thread);
 struct file_elem* get_file (struct list* files, int fd);
+struct file_elem *dup_file (struct file_elem *, int fd);
+void close_file (struct file_elem *);
 void free_resources (struct thread *t);
 
 /* Ryan Driving */
@@ -22,6 +36,20 @@ struct child
     int waited_on;
     int child_exit_code;
 };
+
+/* Cache of `struct child's. */
+extern struct slab_cache child_cache;
 /* End Ryan Driving */ 
 
+/* A thread of a user process other than its leader, as the rest of
+   the process sees it.  Kept in the leader's `threads' list until
+   another thread joins it or the process exits. */
+struct user_thread
+  {
+    tid_t tid;                  /* The thread's identifier. */
+    bool ended;                 /* True once the thread has ended. */
+    bool joining;               /* True once a join has begun. */
+    struct list_elem elem;      /* Element in the leader's `threads'. */
+  };
+
 #endif /* userprog/process.h */
@@ -1,11 +1,15 @@
 #include "userprog/syscall.h"
+#include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <uio.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 /* Sam Driving */
 #include <string.h>
 #include "devices/shutdown.h"
+#include "devices/timer.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "filesys/file.h"
@@ -14,31 +18,127 @@
 #include "pagedir.h"
 #include "devices/input.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "userprog/futex.h"
+#include "userprog/pipe.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 /* End Driving */
 
 /* Miles Driving */
 static void syscall_handler (struct intr_frame *);
 
-static bool valid_ptr (int *ptr);
+static void get_args (struct intr_frame *f, int *args, size_t cnt);
+static char *get_user_string (const char *ustr);
+static int read_fd (struct intr_frame *, int fd, void *ubuf, int size,
+                    off_t *ofs);
+static int write_fd (struct intr_frame *, int fd, const void *ubuf,
+                     int size, off_t *ofs);
+static int transfer_iov (struct intr_frame *, int fd,
+                         const struct iovec *uiov, int iovcnt, bool write);
 /* End Driving */
 
 /* Brian Driving */
-static void halt_handler (void);
-static void exit_handler (struct intr_frame *f);
-static void exec_handler (struct intr_frame *f);
-static void wait_handler (struct intr_frame *f);
-static void create_handler (struct intr_frame *f);
-static void remove_handler (struct intr_frame *f);
-static void open_handler (struct intr_frame *f);
-static void filesize_handler (struct intr_frame *f);
-static void read_handler (struct intr_frame *f);
-static void write_handler (struct intr_frame *f);
-static void seek_handler (struct intr_frame *f);
-static void tell_handler (struct intr_frame *f);
-static void close_handler (struct intr_frame *f);
+static void halt_handler (struct intr_frame *f, int args[]);
+static void exit_handler (struct intr_frame *f, int args[]);
+static void exec_handler (struct intr_frame *f, int args[]);
+static void wait_handler (struct intr_frame *f, int args[]);
+static void create_handler (struct intr_frame *f, int args[]);
+static void remove_handler (struct intr_frame *f, int args[]);
+static void open_handler (struct intr_frame *f, int args[]);
+static void filesize_handler (struct intr_frame *f, int args[]);
+static void read_handler (struct intr_frame *f, int args[]);
+static void write_handler (struct intr_frame *f, int args[]);
+static void seek_handler (struct intr_frame *f, int args[]);
+static void tell_handler (struct intr_frame *f, int args[]);
+static void close_handler (struct intr_frame *f, int args[]);
+static void pread_handler (struct intr_frame *f, int args[]);
+static void pwrite_handler (struct intr_frame *f, int args[]);
+static void readv_handler (struct intr_frame *f, int args[]);
+static void writev_handler (struct intr_frame *f, int args[]);
+static void pipe_handler (struct intr_frame *f, int args[]);
+static void dup2_handler (struct intr_frame *f, int args[]);
+static void futex_wait_handler (struct intr_frame *f, int args[]);
+static void futex_wake_handler (struct intr_frame *f, int args[]);
+static void spawn_thread_handler (struct intr_frame *f, int args[]);
+static void join_thread_handler (struct intr_frame *f, int args[]);
+static void exit_thread_handler (struct intr_frame *f, int args[]);
+#ifdef VM
+static void mmap_handler (struct intr_frame *f, int args[]);
+static void munmap_handler (struct intr_frame *f, int args[]);
+static void fork_handler (struct intr_frame *f, int args[]);
+#endif
 static void error_exit (int exit_status);
 /* End Driving */
 
+struct slab_cache file_elem_cache;
+
+/* Number of iovecs that readv and writev copy in at a time. */
+#define IOV_BATCH 16
+
+/* Bound on the new descriptor in dup2, which leaves room for
+   later opens to number their descriptors past it. */
+#define DUP2_FD_LIMIT 1024
+
+/* Most arguments that any system call takes. */
+#define SYSCALL_MAX_ARGS 4
+
+/* A system call handler.  ARGS holds the call's arguments, already
+   copied from the user stack; results go in F->eax. */
+typedef void syscall_func (struct intr_frame *f, int args[]);
+
+/* A system call. */
+struct syscall
+  {
+    syscall_func *func;         /* Handler, or null if unimplemented. */
+    size_t arg_cnt;             /* Number of arguments. */
+    const char *name;           /* Name, for statistics. */
+  };
+
+/* System calls, indexed by number. */
+static const struct syscall syscalls[] =
+  {
+    [SYS_HALT] = {halt_handler, 0, "halt"},
+    [SYS_EXIT] = {exit_handler, 1, "exit"},
+    [SYS_EXEC] = {exec_handler, 1, "exec"},
+    [SYS_WAIT] = {wait_handler, 1, "wait"},
+    [SYS_CREATE] = {create_handler, 2, "create"},
+    [SYS_REMOVE] = {remove_handler, 1, "remove"},
+    [SYS_OPEN] = {open_handler, 1, "open"},
+    [SYS_FILESIZE] = {filesize_handler, 1, "filesize"},
+    [SYS_READ] = {read_handler, 3, "read"},
+    [SYS_WRITE] = {write_handler, 3, "write"},
+    [SYS_SEEK] = {seek_handler, 2, "seek"},
+    [SYS_TELL] = {tell_handler, 1, "tell"},
+    [SYS_CLOSE] = {close_handler, 1, "close"},
+#ifdef VM
+    [SYS_MMAP] = {mmap_handler, 2, "mmap"},
+    [SYS_MUNMAP] = {munmap_handler, 1, "munmap"},
+    [SYS_FORK] = {fork_handler, 0, "fork"},
+#endif
+    [SYS_PREAD] = {pread_handler, 4, "pread"},
+    [SYS_PWRITE] = {pwrite_handler, 4, "pwrite"},
+    [SYS_READV] = {readv_handler, 3, "readv"},
+    [SYS_WRITEV] = {writev_handler, 3, "writev"},
+    [SYS_PIPE] = {pipe_handler, 1, "pipe"},
+    [SYS_DUP2] = {dup2_handler, 2, "dup2"},
+    [SYS_FUTEX_WAIT] = {futex_wait_handler, 2, "futex_wait"},
+    [SYS_FUTEX_WAKE] = {futex_wake_handler, 2, "futex_wake"},
+    [SYS_SPAWN_THREAD] = {spawn_thread_handler, 3, "spawn_thread"},
+    [SYS_JOIN_THREAD] = {join_thread_handler, 1, "join_thread"},
+    [SYS_EXIT_THREAD] = {exit_thread_handler, 0, "exit_thread"},
+  };
+
+/* Number of entries in SYSCALLS. */
+#define SYSCALL_CNT (sizeof syscalls / sizeof *syscalls)
+
+/* Number of times each system call was made, and the timer ticks
+   spent in its handler.  Updated with interrupts off. */
+static unsigned long long syscall_calls[SYSCALL_CNT];
+static int64_t syscall_ticks[SYSCALL_CNT];
 
 /* Handles all syscalls */
 void
@@ -46,6 +146,10 @@ syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
   lock_init (&file_sys_lock);
+  slab_cache_init (&file_elem_cache, "file_elem", sizeof (struct file_elem),
+                   NULL);
+  futex_init ();
+  pipe_init ();
 }
 
 
@@ -53,80 +157,370 @@ syscall_init (void)
 static void
 syscall_handler (struct intr_frame *f) 
 {
-  int* my_esp = f->esp;
+  const struct syscall *sc;
+  int args[SYSCALL_MAX_ARGS];
+  int syscall_num;
+  enum intr_level old_level;
+  int64_t start;
   
-  if (!valid_ptr (my_esp))
+#ifdef VM
+  /* Page faults taken on user buffers below need the user's
+     stack pointer to tell whether the stack is growing. */
+  thread_current ()->user_esp = f->esp;
+#endif
+
+  if (!copy_from_user (&syscall_num, f->esp, sizeof syscall_num)
+      || syscall_num < 0 || (size_t) syscall_num >= SYSCALL_CNT
+      || syscalls[syscall_num].func == NULL)
   {
     /* BAD! */
     error_exit(-1);
   }
-  int syscall_num = *(my_esp);
+  sc = &syscalls[syscall_num];
+  get_args (f, args, sc->arg_cnt);
 
-  switch (syscall_num)
-  {
-    case SYS_HALT :
-      halt_handler ();
-      break;
-    case SYS_EXIT :
-      exit_handler (f);
-      break;
-    case SYS_EXEC :
-      exec_handler (f);
-      break;
-    case SYS_WAIT :
-      wait_handler (f);
-      break;
-    case SYS_CREATE :
-      create_handler (f);
-      break;
-    case SYS_REMOVE :
-      remove_handler (f);
-      break;
-    case SYS_OPEN :
-      open_handler (f);
-      break;
-    case SYS_FILESIZE :
-      filesize_handler (f);
-      break;
-    case SYS_READ :
-      read_handler (f);
-      break;
-    case SYS_WRITE :
-      write_handler (f);
-      break;
-    case SYS_SEEK :
-      seek_handler (f);
-      break;
-    case SYS_TELL :
-      tell_handler (f);
-      break;
-    case SYS_CLOSE :
-      close_handler (f);
-      break;
-    default :
-      error_exit (-1);
-      break;
-  }
+  /* Once some thread has called exit(), the process's other
+     threads end here on their way into the kernel, and in
+     intr_handler() on their way out. */
+  if (process_current ()->exiting)
+    thread_exit ();
+
+  old_level = intr_disable ();
+  syscall_calls[syscall_num]++;
+  intr_set_level (old_level);
+
+  /* A handler that doesn't return, such as exit's, isn't charged
+     for its time. */
+  start = timer_ticks ();
+  sc->func (f, args);
+
+  old_level = intr_disable ();
+  syscall_ticks[syscall_num] += timer_elapsed (start);
+  intr_set_level (old_level);
 }
-/* End Driving */
 
-/* Miles Driving */
-/* Returns true iff ptr is properly allocated in user memory */
-bool
-valid_ptr (int *ptr)
+/* Prints the number of calls to, and ticks spent in, each system
+   call that has been made. */
+void
+syscall_print_stats (void)
 {
-  struct thread *cur = thread_current ();
+  size_t i;
 
-  return !(ptr == NULL || is_kernel_vaddr (ptr) ||
-           pagedir_get_page (cur->pagedir, ptr) == NULL);
+  for (i = 0; i < SYSCALL_CNT; i++)
+    if (syscall_calls[i] > 0)
+      printf ("Syscall %s: %llu calls, %"PRId64" ticks\n",
+              syscalls[i].name, syscall_calls[i], syscall_ticks[i]);
 }
 /* End Driving */
 
+/* Copies the CNT arguments of the system call in F, which follow
+   the system call number on the user stack, into ARGS.  Kills
+   the process if the user stack cannot be read.  This is the only
+   place that system call arguments are read from user memory. */
+static void
+get_args (struct intr_frame *f, int *args, size_t cnt)
+{
+  if (!copy_from_user (args, (int *) f->esp + 1, cnt * sizeof *args))
+    error_exit (-1);
+}
+
+/* Copies the user string USTR into a newly allocated page, which
+   the caller must free with palloc_free_page(), truncating it to
+   fit.  Kills the process if the string cannot be read.  Returns
+   a null pointer if no page is available. */
+static char *
+get_user_string (const char *ustr)
+{
+  char *kstr = palloc_get_page (0);
+  if (kstr != NULL && !copy_string_from_user (kstr, ustr, PGSIZE))
+    {
+      palloc_free_page (kstr);
+      error_exit (-1);
+    }
+  return kstr;
+}
+
+/* Most bytes of a user buffer that read_fd() and write_fd() hold
+   at once.  Holding a whole buffer could take more frames than
+   there are to pin, so a long transfer is broken into chunks,
+   each ending on a page boundary so that it spans at most
+   XFER_CHUNK / PGSIZE pages. */
+#define XFER_CHUNK (4 * PGSIZE)
+
+/* Returns how many of the SIZE bytes at user address UBUF belong
+   to the first chunk of a transfer. */
+static int
+chunk_size (const void *ubuf, int size)
+{
+  int room = XFER_CHUNK - pg_ofs (ubuf);
+  return size < room ? size : room;
+}
+
+/* Checks that the SIZE-byte user buffer UBUF can be read, or if
+   WRITE is true written, by the process that made the system call
+   in F.  With virtual memory, also keeps the buffer resident, so
+   that the file system can move data to or from it directly,
+   until release_buffer().  Returns true if successful, false if
+   the buffer cannot be accessed or, with virtual memory, memory
+   is short. */
+static bool
+hold_buffer (struct intr_frame *f UNUSED, const void *ubuf, int size,
+             bool write)
+{
+#ifdef VM
+  return size >= 0 && page_pin (ubuf, size, f->esp, write);
+#else
+  return size >= 0 && probe_user (ubuf, size, write);
+#endif
+}
+
+/* Releases a buffer held by hold_buffer(). */
+static void
+release_buffer (const void *ubuf UNUSED, int size UNUSED)
+{
+#ifdef VM
+  page_unpin (ubuf, size);
+#endif
+}
+
+/* Reads SIZE keys from the keyboard into BUF, stopping early only
+   if the running process is ending, and returns the number read.
+   Interrupts stay off from the check of the process to the wait
+   for keys, so that process_terminate() cannot set the flag and
+   call input_wake() in between. */
+static int
+read_keyboard (uint8_t *buf, int size)
+{
+  enum intr_level old_level = intr_disable ();
+  int cnt = 0;
+
+  while (cnt < size && !process_current ()->exiting)
+    cnt += input_read (buf + cnt, size - cnt, false);
+  intr_set_level (old_level);
+  return cnt;
+}
+
+/* Reads SIZE bytes from FD into user buffer UBUF, for the system
+   call in F, holding the buffer a chunk at a time.  A file is
+   read at *OFS if OFS is nonnull, otherwise at its current
+   position; a pipe or the keyboard, which fd 0 reads unless it
+   has been redirected, cannot be read at an offset.  A pipe is
+   read only once, into the first chunk, since a second read
+   could wait for data that may never come.  Returns the number
+   of bytes read, or -1 if FD cannot be read.  Kills the process
+   if UBUF cannot be written. */
+static int
+read_fd (struct intr_frame *f, int fd, void *ubuf_, int size, off_t *ofs)
+{
+  uint8_t *ubuf = ubuf_;
+  struct file_elem *e;
+  struct pipe *pipe = NULL;
+  bool is_file;
+  int total = 0;
+
+  if (size < 0)
+    error_exit (-1);
+
+  lock_acquire (&file_sys_lock);
+  e = get_file (&process_current ()->file_list, fd);
+  is_file = e != NULL && e->file != NULL;
+  if (e != NULL && e->file == NULL && !e->pipe_writer && ofs == NULL)
+    {
+      /* Another thread may close FD while we wait. */
+      pipe = e->pipe;
+      pipe_dup (pipe, false);
+    }
+  lock_release (&file_sys_lock);
+  if (!is_file && pipe == NULL
+      && !(e == NULL && fd == STDIN_FILENO && ofs == NULL))
+    return -1;
+
+  do
+    {
+      uint8_t *chunk = ubuf + total;
+      int chunk_len = chunk_size (chunk, size - total);
+      int cnt;
+
+      if (!hold_buffer (f, chunk, chunk_len, true))
+        {
+          if (pipe != NULL)
+            pipe_close (pipe, false);
+          error_exit (-1);
+        }
+      if (pipe != NULL)
+        /* Don't hold the file system lock while waiting for input. */
+        cnt = pipe_read (pipe, chunk, chunk_len);
+      else if (!is_file)
+        cnt = read_keyboard (chunk, chunk_len);
+      else
+        {
+          /* Look FD up again, in case another thread closed it. */
+          lock_acquire (&file_sys_lock);
+          e = get_file (&process_current ()->file_list, fd);
+          if (e == NULL || e->file == NULL)
+            cnt = -1;
+          else if (ofs != NULL)
+            cnt = file_read_at (e->file, chunk, chunk_len, *ofs + total);
+          else
+            cnt = file_read (e->file, chunk, chunk_len);
+          lock_release (&file_sys_lock);
+        }
+      release_buffer (chunk, chunk_len);
+
+      if (cnt < 0)
+        {
+          if (total == 0)
+            total = -1;
+          break;
+        }
+      total += cnt;
+      if (cnt < chunk_len || pipe != NULL)
+        break;
+    }
+  while (total < size);
+
+  if (pipe != NULL)
+    pipe_close (pipe, false);
+  return total;
+}
+
+/* Writes SIZE bytes from user buffer UBUF to FD, for the system
+   call in F, holding the buffer a chunk at a time.  A file is
+   written at *OFS if OFS is nonnull, otherwise at its current
+   position; a pipe or the console, which fd 1 writes unless it
+   has been redirected, cannot be written at an offset.  Returns
+   the number of bytes written, or -1 if FD cannot be written.
+   Kills the process if UBUF cannot be read. */
+static int
+write_fd (struct intr_frame *f, int fd, const void *ubuf_, int size,
+          off_t *ofs)
+{
+  const uint8_t *ubuf = ubuf_;
+  struct file_elem *e;
+  struct pipe *pipe = NULL;
+  bool is_file;
+  int total = 0;
+
+  if (size < 0)
+    error_exit (-1);
+
+  lock_acquire (&file_sys_lock);
+  e = get_file (&process_current ()->file_list, fd);
+  is_file = e != NULL && e->file != NULL;
+  if (e != NULL && e->file == NULL && e->pipe_writer && ofs == NULL)
+    {
+      /* Another thread may close FD while we wait. */
+      pipe = e->pipe;
+      pipe_dup (pipe, true);
+    }
+  lock_release (&file_sys_lock);
+  if (!is_file && pipe == NULL
+      && !(e == NULL && fd == STDOUT_FILENO && ofs == NULL))
+    return -1;
+
+  do
+    {
+      const uint8_t *chunk = ubuf + total;
+      int chunk_len = chunk_size (chunk, size - total);
+      int cnt;
+
+      if (!hold_buffer (f, chunk, chunk_len, false))
+        {
+          if (pipe != NULL)
+            pipe_close (pipe, true);
+          error_exit (-1);
+        }
+      if (pipe != NULL)
+        /* Don't hold the file system lock while waiting for a
+           reader. */
+        cnt = pipe_write (pipe, chunk, chunk_len);
+      else if (!is_file)
+        {
+          putbuf ((const char *) chunk, chunk_len);
+          cnt = chunk_len;
+        }
+      else
+        {
+          /* Look FD up again, in case another thread closed it. */
+          lock_acquire (&file_sys_lock);
+          e = get_file (&process_current ()->file_list, fd);
+          if (e == NULL || e->file == NULL)
+            cnt = -1;
+          else if (ofs != NULL)
+            cnt = file_write_at (e->file, chunk, chunk_len, *ofs + total);
+          else
+            cnt = file_write (e->file, chunk, chunk_len);
+          lock_release (&file_sys_lock);
+        }
+      release_buffer (chunk, chunk_len);
+
+      if (cnt < 0)
+        {
+          if (total == 0)
+            total = -1;
+          break;
+        }
+      total += cnt;
+      if (cnt < chunk_len)
+        break;
+    }
+  while (total < size);
+
+  if (pipe != NULL)
+    pipe_close (pipe, true);
+  return total;
+}
+
+/* Reads from FD into, or if WRITE is true writes to FD from, the
+   IOVCNT user buffers described by the user array UIOV, for the
+   system call in F, stopping early after a short transfer.
+   Returns the total number of bytes transferred, or -1 if IOVCNT
+   is out of range, FD cannot be read or written, or the first
+   buffer alone is longer than INT_MAX.  The total is kept within
+   the range of an int by stopping before a later buffer that
+   would take it past INT_MAX. */
+static int
+transfer_iov (struct intr_frame *f, int fd, const struct iovec *uiov,
+              int iovcnt, bool write)
+{
+  struct iovec iov[IOV_BATCH];
+  int total = 0;
+  int i;
+
+  if (iovcnt < 0 || iovcnt > IOV_MAX)
+    return -1;
+
+  for (i = 0; i < iovcnt; i++)
+    {
+      struct iovec *v = &iov[i % IOV_BATCH];
+      int cnt;
+
+      /* Copy the array from user memory a batch at a time. */
+      if (i % IOV_BATCH == 0)
+        {
+          int batch = iovcnt - i < IOV_BATCH ? iovcnt - i : IOV_BATCH;
+          if (!copy_from_user (iov, uiov + i, batch * sizeof *iov))
+            error_exit (-1);
+        }
+
+      if (v->iov_len > (size_t) (INT_MAX - total))
+        return i == 0 ? -1 : total;
+      cnt = (write ? write_fd (f, fd, v->iov_base, v->iov_len, NULL)
+             : read_fd (f, fd, v->iov_base, v->iov_len, NULL));
+      if (cnt < 0)
+        return i == 0 ? -1 : total;
+      total += cnt;
+      if ((size_t) cnt < v->iov_len)
+        break;
+    }
+  return total;
+}
+
 
 /* Brian Driving */
 /* Terminates Pintos by calling shutdown_power_off() */
 static void
-halt_handler ()
+halt_handler (struct intr_frame *f UNUSED, int args[] UNUSED)
 {
   shutdown_power_off ();
 }
@@ -139,10 +533,7 @@ halt_handler ()
 static void 
 error_exit (int exit_status)
 {
-  struct thread *cur = thread_current ();
-  cur->exit_code = exit_status;
-  
-  thread_exit ();
+  process_terminate (exit_status);
 }
 /* End Driving */
 
@@ -151,22 +542,11 @@ error_exit (int exit_status)
 /* Terminates the current user program, returning status to the kernel. 
    If the process's parent waits for it, this is the status that will be 
    returned. Conventionally, a status of 0 indicates success and nonzero
-   values indicate errors. */
+   values indicate errors.  Every thread of the program ends. */
 static void
-exit_handler (struct intr_frame *f)
+exit_handler (struct intr_frame *f UNUSED, int args[])
 {
-  /* grab the esp off intr_frame */
-  int *my_esp = f->esp;
-
-  if (valid_ptr (my_esp + 1))
-  {
-    thread_current ()->exit_code = *(my_esp + 1);
-    thread_exit ();
-  }
-  else
-  {
-    error_exit (-1);
-  }
+  process_terminate (args[0]);
 }
 /* End Driving */
 
@@ -178,18 +558,9 @@ exit_handler (struct intr_frame *f)
    but was terminated by the kernel (e.g. killed due to an exception), 
    wait(pid) must return -1. */
 static void 
-wait_handler (struct intr_frame *f)
+wait_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = f->esp;
-  /* check valid pointer */
-  if (valid_ptr (my_esp + 1))
-  {
-    f->eax = process_wait (*(my_esp + 1));
-  }
-  else
-  {
-    error_exit (-1);
-  }
+  f->eax = process_wait (args[0]);
 }
 /* End Driving */
 
@@ -200,25 +571,21 @@ wait_handler (struct intr_frame *f)
   not open it: opening the new file is a separate operation which would
   require a open system call. */
 static void 
-create_handler (struct intr_frame *f)
+create_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = (int*) f->esp;
-  if (valid_ptr (my_esp + 1) && valid_ptr (my_esp + 2)
-      && valid_ptr ((int*) *(my_esp + 1)))
-  { /* both args are valid. */
-    lock_acquire (&file_sys_lock);
+  /* Make args into clear var names */
+  char *f_name = get_user_string ((const char *) args[0]);
+  unsigned initial_size = (unsigned) args[1];
 
-    /* Make args into clear var names */
-    char *f_name = (char*) *(my_esp + 1);
-    unsigned initial_size = (unsigned) *(my_esp + 2);
-
-    f->eax = filesys_create (f_name, initial_size);
-    lock_release (&file_sys_lock);
-  }
-  else
+  if (f_name == NULL)
   {
-    error_exit (-1);
+    f->eax = false;
+    return;
   }
+  lock_acquire (&file_sys_lock);
+  f->eax = filesys_create (f_name, initial_size);
+  lock_release (&file_sys_lock);
+  palloc_free_page (f_name);
 }
 /* End Driving */
 
@@ -226,37 +593,29 @@ create_handler (struct intr_frame *f)
 /* Brian Driving */
 /* Returns the size, in bytes, of the file open as fd. */
 static void 
-filesize_handler (struct intr_frame *f)
+filesize_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = (int*) f->esp;
-  if (valid_ptr (my_esp + 1))
-  {
-    lock_acquire (&file_sys_lock);
+  lock_acquire (&file_sys_lock);
 
-    struct list_elem *iterator;
-    struct file_elem *cur_file;
-    struct list *cur_file_list = &thread_current ()->file_list;
+  struct list_elem *iterator;
+  struct file_elem *cur_file;
+  struct list *cur_file_list = &process_current ()->file_list;
 
-    int fd = *(my_esp + 1);
+  int fd = args[0];
 
-    /* Loop thru file list until fd is found */
-    for (iterator = list_begin (cur_file_list);
-         iterator != list_end (cur_file_list);
-         iterator = list_next (iterator))
+  /* Loop thru file list until fd is found */
+  for (iterator = list_begin (cur_file_list);
+       iterator != list_end (cur_file_list);
+       iterator = list_next (iterator))
+    {
+      cur_file = list_entry (iterator, struct file_elem, elem);
+      if (cur_file != NULL && cur_file->fd == fd && cur_file->file != NULL)
       {
-        cur_file = list_entry (iterator, struct file_elem, elem);
-        if (cur_file != NULL && cur_file->fd == fd)
-        {
-          /* Set return value to size */
-          f->eax = file_length (cur_file->file);
-        }
+        /* Set return value to size */
+        f->eax = file_length (cur_file->file);
       }
-    lock_release (&file_sys_lock);
-  }
-  else
-  {
-    error_exit (-1);
-  }
+    }
+  lock_release (&file_sys_lock);
 }
 /* End Driving */
 
@@ -265,60 +624,11 @@ filesize_handler (struct intr_frame *f)
 /* Reads size bytes from the file open as fd into buffer. Returns the number
    of bytes actually read (0 at end of file), or -1 if the file could not be 
    read (due to a condition other than end of file). fd 0 reads from the 
-   keyboard using input_getc(). */
+   keyboard using input_read(). */
 static void 
-read_handler (struct intr_frame *f)
+read_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = (int*) f->esp;
-  /* Check second to last arg's content and then last arg */
-  if (valid_ptr (my_esp + 1) && valid_ptr (my_esp + 2)
-      && valid_ptr (my_esp + 3) && valid_ptr ((int*) *(my_esp + 2)))
-  {
-    /* Make args into clear var names */
-    int fd = *(my_esp + 1);
-    char **buf_ptr = (char**)(my_esp + 2);
-    int size = *(my_esp + 3);
-    char *buf = *buf_ptr;
-    if (fd == 0)
-    { 
-      uint8_t *buff_ptr = (uint8_t*) buf;
-      int i;
-      for (i = 0; i < size; i++)
-      {
-        buff_ptr[i] = input_getc ();
-      }
-      f->eax = size;
-    }
-    else
-    {
-      struct list_elem *iterator;
-      struct file_elem *cur_file;
-      lock_acquire (&file_sys_lock);
-      struct list *cur_file_list = &thread_current ()->file_list;
-
-      /* Loop thru file list until fd is found */
-      for (iterator = list_begin(cur_file_list);
-           iterator != list_end (cur_file_list);
-           iterator = list_next (iterator))
-      {
-        cur_file = list_entry (iterator, struct file_elem, elem);
-        if (cur_file != NULL && cur_file->fd == fd)
-        {
-          f->eax = file_read (cur_file->file, (void*) buf, size);
-          break;
-        }
-        else
-        {
-          f->eax = -1;
-        }
-      }
-      lock_release (&file_sys_lock);
-    }
-  }
-  else
-  {
-    error_exit (-1);
-  }
+  f->eax = read_fd (f, args[0], (void *) args[1], args[2], NULL);
 }
 /* End Driving */
 
@@ -328,56 +638,9 @@ read_handler (struct intr_frame *f)
    bytes actually written, which may be less than size if some bytes could not
    be written. */
 static void 
-write_handler (struct intr_frame *f)
+write_handler (struct intr_frame *f, int args[])
 { 
-  int *my_esp = (int*) f->esp;
-
-  /* Check second to last arg's content and then last arg */
-  if (valid_ptr (my_esp + 1) && valid_ptr (my_esp + 2)
-      && valid_ptr (my_esp + 3) && valid_ptr ((int *)(*(my_esp + 2))))
-  {
-    /* Make args into clear var names */
-    int fd = *(my_esp + 1);
-    char **buf_ptr = (char**)(my_esp + 2);
-    int size = *(my_esp + 3);
-    char *buf = *buf_ptr;
-   
-    if (fd == 1)
-    { /* Write to console */
-      putbuf (buf, size);
-      f->eax = size;
-    }
-    else
-    {
-      struct list_elem *iterator;
-      struct file_elem *cur_file;
-      lock_acquire (&file_sys_lock);
-      struct list *cur_file_list = &thread_current ()->file_list;
-
-      /* Loop thru file list until fd is found */
-      for (iterator = list_begin (cur_file_list);
-           iterator != list_end (cur_file_list);
-           iterator = list_next (iterator))
-        {
-          cur_file = list_entry (iterator, struct file_elem, elem);
-          if (cur_file != NULL && cur_file->fd == fd)
-          {
-            f->eax = file_write (cur_file->file, (void*) (*(my_esp + 2)),
-                    *(my_esp + 3));
-            break;
-          }
-          else
-          {
-            f->eax = -1;
-          }
-        }
-        lock_release (&file_sys_lock);
-    }
-  }
-  else
-  {
-    error_exit (-1);
-  }
+  f->eax = write_fd (f, args[0], (const void *) args[1], args[2], NULL);
 }
 /* End Driving */
 
@@ -387,37 +650,29 @@ write_handler (struct intr_frame *f)
    expressed in bytes from the beginning of the file. (Thus, a position of 0 is
    the file's start.) */
 static void 
-seek_handler (struct intr_frame *f)
+seek_handler (struct intr_frame *f UNUSED, int args[])
 {
-  int *my_esp = (int*) f->esp;
-  if (valid_ptr (my_esp + 1) && valid_ptr (my_esp + 2))
-  {
-    lock_acquire (&file_sys_lock);
+  lock_acquire (&file_sys_lock);
 
-    struct list_elem *iterator;
-    struct file_elem *cur_file;
-    struct list *cur_file_list = &thread_current ()->file_list;
+  struct list_elem *iterator;
+  struct file_elem *cur_file;
+  struct list *cur_file_list = &process_current ()->file_list;
 
-    int fd = *(my_esp + 1);
-    unsigned int position = *(my_esp + 2);
+  int fd = args[0];
+  unsigned int position = args[1];
 
-    /* Loop thru file list until fd is found */
-    for (iterator = list_begin (cur_file_list);
-         iterator != list_end (cur_file_list);
-         iterator = list_next (iterator))
+  /* Loop thru file list until fd is found */
+  for (iterator = list_begin (cur_file_list);
+       iterator != list_end (cur_file_list);
+       iterator = list_next (iterator))
+    {
+      cur_file = list_entry (iterator, struct file_elem, elem);
+      if (cur_file != NULL && cur_file->fd == fd && cur_file->file != NULL)
       {
-        cur_file = list_entry (iterator, struct file_elem, elem);
-        if (cur_file != NULL && cur_file->fd == fd)
-        {
-          file_seek (cur_file->file, position);
-        }
+        file_seek (cur_file->file, position);
       }
-    lock_release (&file_sys_lock);
-  }
-  else
-  {
-    error_exit (-1);
-  }
+    }
+  lock_release (&file_sys_lock);
 }
 /* End Driving */
 
@@ -426,36 +681,28 @@ seek_handler (struct intr_frame *f)
 /* Returns the position of the next byte to be read or written in open file fd,
    expressed in bytes from the beginning of the file. */
 static void 
-tell_handler (struct intr_frame *f)
+tell_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = (int*) f->esp;
-  if (valid_ptr (my_esp + 1))
-  {
-    lock_acquire (&file_sys_lock);
+  lock_acquire (&file_sys_lock);
 
-    struct list_elem *iterator;
-    struct file_elem *cur_file;
-    struct list *cur_file_list = &thread_current ()->file_list;
+  struct list_elem *iterator;
+  struct file_elem *cur_file;
+  struct list *cur_file_list = &process_current ()->file_list;
 
-    int fd = *(my_esp + 1);
+  int fd = args[0];
 
-    /* Loop thru file list until fd is found */
-    for (iterator = list_begin (cur_file_list);
-         iterator != list_end (cur_file_list);
-         iterator = list_next (iterator))
+  /* Loop thru file list until fd is found */
+  for (iterator = list_begin (cur_file_list);
+       iterator != list_end (cur_file_list);
+       iterator = list_next (iterator))
+    {
+      cur_file = list_entry (iterator, struct file_elem, elem);
+      if (cur_file != NULL && cur_file->fd == fd && cur_file->file != NULL)
       {
-        cur_file = list_entry (iterator, struct file_elem, elem);
-        if (cur_file != NULL && cur_file->fd == fd)
-        {
-          f->eax = file_tell (cur_file->file); 
-        }
+        f->eax = file_tell (cur_file->file); 
       }
-    lock_release (&file_sys_lock);
-  }
-  else
-  {
-    error_exit (-1);
-  }
+    }
+  lock_release (&file_sys_lock);
 }
 /* End Driving */
 
@@ -463,49 +710,43 @@ tell_handler (struct intr_frame *f)
 /* Miles Driving */
 /* Closes file descriptor fd. Exiting or terminating a process implicitly
    closes all its open file descriptors, as if by calling this function for
-   each one. */
+   each one.  Closing a redirected fd 0 or 1 returns it to the console. */
 static void 
-close_handler (struct intr_frame *f) 
+close_handler (struct intr_frame *f UNUSED, int args[]) 
 {
-  int *my_esp = (int*) f->esp;
-  if (valid_ptr (my_esp + 1) && ((int *)(*(my_esp + 1)) != NULL))
-  {
-    lock_acquire (&file_sys_lock);
+  struct list_elem *iterator;
+  struct file_elem *cur_file = NULL;
+  struct list *cur_file_list = &process_current ()->file_list;
 
-    struct list_elem *iterator;
-    struct file_elem *cur_file = NULL;
-    struct list *cur_file_list = &thread_current ()->file_list;
-
-    int fd = (int)(*(my_esp + 1));
+  int fd = args[0];
 
+  lock_acquire (&file_sys_lock);
+  if ((fd == STDIN_FILENO || fd == STDOUT_FILENO)
+      && get_file (cur_file_list, fd) == NULL)
+  {
+    lock_release (&file_sys_lock);
     /* Verify is not main or idle thread */
-    if (fd == 0 || fd == 1)
-    {
-      lock_release (&file_sys_lock);
-      return;
-    }
+    if (fd == STDIN_FILENO)
+      error_exit (-1);
+    return;
+  }
 
-    /* Loop thru file list until fd is found */
-    for (iterator = list_begin (cur_file_list);
-         iterator != list_end (cur_file_list);
-         iterator = list_next (iterator))
+  /* Loop thru file list until fd is found */
+  for (iterator = list_begin (cur_file_list);
+       iterator != list_end (cur_file_list);
+       iterator = list_next (iterator))
+    {
+      cur_file = list_entry (iterator, struct file_elem, elem);
+      if (cur_file != NULL && cur_file->fd == fd)
       {
-        cur_file = list_entry (iterator, struct file_elem, elem);
-        if (cur_file != NULL && cur_file->fd == fd)
-        {
-          /* Remove file from list */
-          list_remove (iterator);
-          /* Close file. */
-          file_close (cur_file->file);
-          break;
-        }
+        /* Remove file from list */
+        list_remove (iterator);
+        /* Close file. */
+        close_file (cur_file);
+        break;
       }
-    lock_release (&file_sys_lock);
-  }
-  else
-  {
-    error_exit (-1);
-  }
+    }
+  lock_release (&file_sys_lock);
 }
 /* End Driving */
 
@@ -518,21 +759,18 @@ close_handler (struct intr_frame *f)
    exec until it knows whether the child process successfully loaded
    its executable. */
 static void 
-exec_handler (struct intr_frame *f)
+exec_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = (int*) f->esp;
-  if (valid_ptr (my_esp + 1) && valid_ptr ((int *)(*(my_esp + 1))))
-  {
-    /* ptr is valid */
-    char* cmd_line = (char*) *(my_esp + 1);
-    /* Create new process with new args */
-    tid_t new_tid = process_execute (cmd_line);
-    f->eax = new_tid;
-  }
-  else
+  char *cmd_line = get_user_string ((const char *) args[0]);
+  if (cmd_line == NULL)
   {
-    error_exit (-1);
+    f->eax = TID_ERROR;
+    return;
   }
+  /* Create new process with new args */
+  tid_t new_tid = process_execute (cmd_line);
+  palloc_free_page (cmd_line);
+  f->eax = new_tid;
 }
 /* End Driving */
 
@@ -542,21 +780,19 @@ exec_handler (struct intr_frame *f)
    A file may be removed regardless of whether it is open or closed, and 
    removing an open file does not close it. */
 static void 
-remove_handler (struct intr_frame *f)
+remove_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = f->esp;
-  if (valid_ptr (my_esp + 1) && valid_ptr ((int *)(*(my_esp + 1))))
+  char *f_name = get_user_string ((const char *) args[0]);
+  if (f_name == NULL)
   {
-    lock_acquire (&file_sys_lock);
-    /* delete file */
-    f->eax = filesys_remove ((char*) *(my_esp + 1));
-    lock_release (&file_sys_lock);
-  }
-  else
-  {
-    f->eax = -1;
-    error_exit (-1);
+    f->eax = false;
+    return;
   }
+  lock_acquire (&file_sys_lock);
+  /* delete file */
+  f->eax = filesys_remove (f_name);
+  lock_release (&file_sys_lock);
+  palloc_free_page (f_name);
 }
 /* End Driving */
 
@@ -565,38 +801,327 @@ remove_handler (struct intr_frame *f)
 /* Opens the file called file. Returns a nonnegative integer handle called
    a "file descriptor" (fd) or -1 if the file could not be opened. */
 static void 
-open_handler (struct intr_frame *f)
+open_handler (struct intr_frame *f, int args[])
 {
-  int *my_esp = f->esp;
-  if (valid_ptr (my_esp + 1) && valid_ptr ((int *)(*(my_esp + 1))))
+  char *f_name = get_user_string ((const char *) args[0]);
+  if (f_name == NULL)
   {
-    lock_acquire (&file_sys_lock);
-    char *f_name = (char*) (*(my_esp + 1));
-    struct file *cur_file = filesys_open (f_name);
-    lock_release (&file_sys_lock);
-    if (cur_file == NULL)
-    { /* Bad file name */
-      f->eax = -1;
-    }
-    else
+    f->eax = -1;
+    return;
+  }
+  lock_acquire (&file_sys_lock);
+  struct file *cur_file = filesys_open (f_name);
+  lock_release (&file_sys_lock);
+  palloc_free_page (f_name);
+  if (cur_file == NULL)
+  { /* Bad file name */
+    f->eax = -1;
+  }
+  else
+  {
+    struct file_elem *f_elem = slab_alloc (&file_elem_cache);
+    if (f_elem == NULL)
     {
-      struct file_elem *f_elem = malloc (sizeof (struct file_elem));
-      f_elem->file = cur_file;
-      struct thread *cur = thread_current ();
-      /* Create unique fd_count every time file opened */
-      cur->fd_count++;
-      f_elem->fd = cur->fd_count;
       lock_acquire (&file_sys_lock);
-      /* Add to file list */
-      list_push_front (&cur->file_list, &f_elem->elem);
+      file_close (cur_file);
       lock_release (&file_sys_lock);
-      f->eax = f_elem->fd;
+      f->eax = -1;
+      return;
     }
+    f_elem->file = cur_file;
+    f_elem->pipe = NULL;
+    f_elem->pipe_writer = false;
+    struct thread *cur = process_current ();
+    lock_acquire (&file_sys_lock);
+    /* Create unique fd_count every time file opened */
+    cur->fd_count++;
+    f_elem->fd = cur->fd_count;
+    /* Add to file list */
+    list_push_front (&cur->file_list, &f_elem->elem);
+    lock_release (&file_sys_lock);
+    f->eax = f_elem->fd;
   }
+}
+/* End Driving */
+
+
+/* Reads size bytes from the file open as fd into buffer, starting at
+   byte offset ofs in the file, without changing the file's position.
+   Returns the number of bytes actually read, or -1 if fd is not a file
+   open for reading or ofs is negative. */
+static void
+pread_handler (struct intr_frame *f, int args[])
+{
+  off_t ofs = args[3];
+
+  f->eax = (ofs >= 0 ? read_fd (f, args[0], (void *) args[1], args[2], &ofs)
+            : -1);
+}
+
+
+/* Writes size bytes from buffer to the file open as fd, starting at
+   byte offset ofs in the file, without changing the file's position.
+   Returns the number of bytes actually written, or -1 if fd is not a
+   file open for writing or ofs is negative. */
+static void
+pwrite_handler (struct intr_frame *f, int args[])
+{
+  off_t ofs = args[3];
+
+  f->eax = (ofs >= 0
+            ? write_fd (f, args[0], (const void *) args[1], args[2], &ofs)
+            : -1);
+}
+
+
+/* Reads from fd into the iovcnt buffers described by iov, filling each
+   in turn, as if by one read call per buffer that stops at the first
+   short read.  Returns the total number of bytes read, or -1 if fd
+   cannot be read or iovcnt or the total length is out of range. */
+static void
+readv_handler (struct intr_frame *f, int args[])
+{
+  f->eax = transfer_iov (f, args[0], (const struct iovec *) args[1],
+                         args[2], false);
+}
+
+
+/* Writes the iovcnt buffers described by iov to fd in turn, as if by
+   one write call per buffer that stops at the first short write.
+   Returns the total number of bytes written, or -1 if fd cannot be
+   written or iovcnt or the total length is out of range. */
+static void
+writev_handler (struct intr_frame *f, int args[])
+{
+  f->eax = transfer_iov (f, args[0], (const struct iovec *) args[1],
+                         args[2], true);
+}
+
+
+/* Creates a pipe and stores file descriptors for its read end in fds[0]
+   and its write end in fds[1].  Returns 0 if successful, -1 if memory is
+   short.  Bytes written to fds[1] can be read from fds[0]: a read waits
+   until some are available, or returns 0 once every write end is
+   closed, and a write waits until there is room for all of its bytes. */
+static void
+pipe_handler (struct intr_frame *f, int args[])
+{
+  struct thread *cur = process_current ();
+  struct file_elem *ends[2];
+  struct pipe *p;
+  int fds[2];
+  int i;
+
+  ends[0] = slab_alloc (&file_elem_cache);
+  ends[1] = slab_alloc (&file_elem_cache);
+  p = pipe_create ();
+  if (ends[0] == NULL || ends[1] == NULL || p == NULL)
+  {
+    if (ends[0] != NULL)
+      slab_free (&file_elem_cache, ends[0]);
+    if (ends[1] != NULL)
+      slab_free (&file_elem_cache, ends[1]);
+    if (p != NULL)
+    {
+      pipe_close (p, false);
+      pipe_close (p, true);
+    }
+    f->eax = -1;
+    return;
+  }
+
+  lock_acquire (&file_sys_lock);
+  for (i = 0; i < 2; i++)
+  {
+    ends[i]->fd = fds[i] = ++cur->fd_count;
+    ends[i]->file = NULL;
+    ends[i]->pipe = p;
+    ends[i]->pipe_writer = i == 1;
+    list_push_front (&cur->file_list, &ends[i]->elem);
+  }
+  lock_release (&file_sys_lock);
+
+  /* On failure the ends are closed when the process exits. */
+  if (!copy_to_user ((int *) args[0], fds, sizeof fds))
+    error_exit (-1);
+  f->eax = 0;
+}
+
+
+/* Makes newfd refer to the file or pipe end that oldfd refers to, closing
+   newfd first if it is open, and returns newfd, or -1 if oldfd is not
+   open, newfd is negative or at least DUP2_FD_LIMIT, or memory is short.
+   The two descriptors share one file position.  A redirected fd 0 or 1
+   takes the place of the console until it is closed, and is passed on to
+   children started by exec. */
+static void
+dup2_handler (struct intr_frame *f, int args[])
+{
+  struct thread *cur = process_current ();
+  int oldfd = args[0];
+  int newfd = args[1];
+  struct file_elem *old, *copy, *prev;
+
+  lock_acquire (&file_sys_lock);
+  old = get_file (&cur->file_list, oldfd);
+  if (old == NULL || newfd < 0 || newfd >= DUP2_FD_LIMIT)
+    f->eax = -1;
+  else if (oldfd == newfd)
+    f->eax = newfd;
+  else if ((copy = dup_file (old, newfd)) == NULL)
+    f->eax = -1;
   else
   {
+    prev = get_file (&cur->file_list, newfd);
+    if (prev != NULL)
+    {
+      list_remove (&prev->elem);
+      close_file (prev);
+    }
+    list_push_front (&cur->file_list, &copy->elem);
+    /* Keep later opens from reusing newfd. */
+    if (newfd > cur->fd_count)
+      cur->fd_count = newfd;
+    f->eax = newfd;
+  }
+  lock_release (&file_sys_lock);
+}
+
+
+/* Holds the futex word at user address UADDR for the system call in F,
+   as hold_buffer() does, and returns its kernel address, or a null
+   pointer if UADDR is not aligned.  Kills the process if the word is not
+   in its writable memory.  With virtual memory, the process gets a
+   frame of its own rather than one it shares copy-on-write, and the
+   word stays in that frame until release_buffer().  Without, the word
+   is only read, so that the check cannot race with an update from user
+   mode. */
+static const int *
+hold_futex (struct intr_frame *f UNUSED, const int *uaddr)
+{
+  if ((uintptr_t) uaddr % sizeof *uaddr != 0)
+    return NULL;
+#ifdef VM
+  if (!page_pin (uaddr, sizeof *uaddr, f->esp, true))
+#else
+  if (!probe_user (uaddr, sizeof *uaddr, false))
+#endif
     error_exit (-1);
+  return pagedir_get_page (thread_current ()->pagedir, uaddr);
+}
+
+
+/* If the int at addr is expected, sleeps until another thread calls
+   futex_wake on the same memory, and returns 0.  Otherwise returns -1
+   at once, as it does if addr is not aligned.  The check and the sleep
+   are atomic with respect to futex_wake. */
+static void
+futex_wait_handler (struct intr_frame *f, int args[])
+{
+  const int *uaddr = (const int *) args[0];
+  const int *kaddr = hold_futex (f, uaddr);
+
+  if (kaddr == NULL)
+  {
+    f->eax = -1;
+    return;
   }
+  f->eax = futex_wait (kaddr, args[1]) ? 0 : -1;
+  release_buffer (uaddr, sizeof *uaddr);
+}
+
+
+/* Wakes up to n threads sleeping in futex_wait on the int at addr, and
+   returns the number woken, or -1 if addr is not aligned. */
+static void
+futex_wake_handler (struct intr_frame *f, int args[])
+{
+  const int *uaddr = (const int *) args[0];
+  const int *kaddr = hold_futex (f, uaddr);
+
+  if (kaddr == NULL)
+  {
+    f->eax = -1;
+    return;
+  }
+  f->eax = futex_wake (kaddr, args[1]);
+  release_buffer (uaddr, sizeof *uaddr);
+}
+
+
+/* Starts a new thread in the process that calls entry(arg) on the stack
+   whose top is stack, and returns its thread id, or -1 if it could not be
+   started.  The thread shares the process's memory and open files.  entry
+   must not return, but end the thread with exit_thread. */
+static void
+spawn_thread_handler (struct intr_frame *f, int args[])
+{
+  f->eax = process_spawn_thread ((void *) args[0], (void *) args[1],
+                                 (void *) args[2]);
+}
+
+
+/* Waits for thread tid of the process to end.  Returns 0 if successful,
+   -1 if tid is not a thread of the process that another thread could
+   join, such as the process's first thread, or has been joined already. */
+static void
+join_thread_handler (struct intr_frame *f, int args[])
+{
+  f->eax = process_join_thread (args[0]) ? 0 : -1;
 }
-/* End Driving */
 
+
+/* Ends the calling thread.  The process ends when its last thread does,
+   with exit status 0 unless some thread called exit. */
+static void
+exit_thread_handler (struct intr_frame *f UNUSED, int args[] UNUSED)
+{
+  process_exit_thread ();
+}
+
+
+#ifdef VM
+/* Maps the file open as fd into the process's virtual address space
+   starting at addr, and returns a mapping id, or -1 on failure. Pages
+   are read from the file as they are touched; modified pages are written
+   back when evicted, unmapped, or when the process exits. */
+static void
+mmap_handler (struct intr_frame *f, int args[])
+{
+  struct thread *cur = process_current ();
+  struct file_elem *cur_file;
+
+  /* The page table lock comes before the file system lock. */
+  lock_acquire (&cur->pages_lock);
+  lock_acquire (&file_sys_lock);
+  cur_file = get_file (&cur->file_list, args[0]);
+  f->eax = (cur_file != NULL && cur_file->file != NULL
+            ? mmap_map (cur_file->file, (void *) args[1]) : MAP_FAILED);
+  lock_release (&file_sys_lock);
+  lock_release (&cur->pages_lock);
+}
+
+
+/* Unmaps the mapping designated by mapid, writing back any pages of it
+   that were modified. */
+static void
+munmap_handler (struct intr_frame *f UNUSED, int args[])
+{
+  struct thread *cur = process_current ();
+
+  lock_acquire (&cur->pages_lock);
+  mmap_unmap (args[0]);
+  lock_release (&cur->pages_lock);
+}
+
+
+/* Creates a copy of the calling process that shares its memory
+   copy-on-write and has duplicates of its open files. Returns the child's
+   pid to the parent and 0 to the child, or -1 if the child could not be
+   created. */
+static void
+fork_handler (struct intr_frame *f, int args[] UNUSED)
+{
+  f->eax = process_fork (f);
+}
+#endif
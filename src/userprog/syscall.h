@@ -2,20 +2,28 @@
 #define USERPROG_SYSCALL_H
 
 #include "list.h"
+#include "threads/slab.h"
 
 /* Brian Driving */
 void syscall_init (void);
+void syscall_print_stats (void);
 
 /*locks file access*/
 struct lock file_sys_lock;
 
 
+/* An open file descriptor: either a file or one end of a pipe. */
 struct file_elem
 {
     int fd;
-    struct file *file;
+    struct file *file;          /* File, or null for a pipe end. */
+    struct pipe *pipe;          /* Pipe, or null for a file. */
+    bool pipe_writer;           /* True for the write end of PIPE. */
     struct list_elem elem;
  };
+
+/* Cache of `struct file_elem's. */
+extern struct slab_cache file_elem_cache;
  /* End Driving */
 
 #endif /* userprog/syscall.h */
\ No newline at end of file
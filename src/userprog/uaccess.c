@@ -0,0 +1,190 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* Access to user memory from the kernel.
+
+   The functions here touch user memory directly, without first
+   looking up each page in the page directory.  Each instruction
+   that may fault on a user address is listed, with the address
+   at which to resume, in the .uaccess_fixups section, which the
+   linker script gathers into a table.  When the kernel faults on
+   a user address that cannot be brought in, the page fault
+   handler calls uaccess_fixup(), which finds the faulting
+   instruction in the table, sets EAX to 0, and resumes at its
+   fixup address.  Each access is written to leave a nonzero
+   value in EAX if it completes, so EAX tells the caller whether
+   the access faulted.
+
+   Callers must still keep the kernel's own memory out of reach:
+   every function checks that the whole of its user range lies
+   below PHYS_BASE.  That comparison is the only cost when the
+   access succeeds. */
+
+/* An entry in the fixup table. */
+struct uaccess_fixup
+  {
+    uintptr_t insn;             /* Instruction that may fault. */
+    uintptr_t fixup;            /* Where to resume if it does. */
+  };
+
+/* The fixup table, from the linker script. */
+extern const struct uaccess_fixup _start_uaccess_fixups[];
+extern const struct uaccess_fixup _end_uaccess_fixups[];
+
+/* Adds a fixup table entry for the instruction at label INSN,
+   resuming at label FIXUP. */
+#define FIXUP(INSN, FIXUP)                                      \
+        ".pushsection .uaccess_fixups, \"a\"\n"                 \
+        ".balign 4\n"                                           \
+        ".long " INSN ", " FIXUP "\n"                           \
+        ".popsection\n"
+
+/* Returns true if the SIZE bytes starting at UADDR are all user
+   virtual addresses. */
+static inline bool
+is_user_range (const void *uaddr, size_t size)
+{
+  return (uintptr_t) uaddr <= (uintptr_t) PHYS_BASE
+         && size <= (uintptr_t) PHYS_BASE - (uintptr_t) uaddr;
+}
+
+/* Reads a byte at user virtual address USRC into *DST.
+   Returns true if successful, false if a segfault occurred. */
+bool
+get_user (uint8_t *dst, const uint8_t *usrc)
+{
+  int ok;
+  uint8_t byte;
+
+  if (!is_user_vaddr (usrc))
+    return false;
+  asm volatile ("1: movb %2, %b1\n"
+                "2:\n"
+                FIXUP ("1b", "2b")
+                : "=a" (ok), "=q" (byte) : "m" (*usrc), "0" (1));
+  *dst = byte;
+  return ok != 0;
+}
+
+/* Writes BYTE to user address UDST.
+   Returns true if successful, false if a segfault occurred. */
+bool
+put_user (uint8_t *udst, uint8_t byte)
+{
+  int ok;
+
+  if (!is_user_vaddr (udst))
+    return false;
+  asm volatile ("1: movb %b2, %1\n"
+                "2:\n"
+                FIXUP ("1b", "2b")
+                : "=a" (ok), "=m" (*udst) : "q" (byte), "0" (1));
+  return ok != 0;
+}
+
+/* Copies SIZE bytes from user address USRC to DST.
+   Returns true if successful, false if a segfault occurred, in
+   which case DST may have been partly written. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  int ok = 1;
+
+  if (!is_user_range (usrc, size))
+    return false;
+  asm volatile ("1: rep movsb\n"
+                "2:\n"
+                FIXUP ("1b", "2b")
+                : "+a" (ok), "+D" (dst), "+S" (usrc), "+c" (size)
+                : : "memory");
+  return ok != 0;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.
+   Returns true if successful, false if a segfault occurred, in
+   which case UDST may have been partly written. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  int ok = 1;
+
+  if (!is_user_range (udst, size))
+    return false;
+  asm volatile ("1: rep movsb\n"
+                "2:\n"
+                FIXUP ("1b", "2b")
+                : "+a" (ok), "+D" (udst), "+S" (src), "+c" (size)
+                : : "memory");
+  return ok != 0;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   DST, a buffer of SIZE bytes, truncating it if necessary.  DST
+   is always null-terminated.  Returns true if successful, false
+   if a segfault occurred before the end of the string. */
+bool
+copy_string_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t i;
+
+  ASSERT (size > 0);
+
+  for (i = 0; i + 1 < size; i++)
+    {
+      if (!get_user ((uint8_t *) &dst[i], (const uint8_t *) &usrc[i]))
+        {
+          dst[i] = '\0';
+          return false;
+        }
+      if (dst[i] == '\0')
+        return true;
+    }
+  dst[i] = '\0';
+  return true;
+}
+
+/* Checks that every byte of the SIZE-byte user buffer UBUF can
+   be read, or if WRITE is true written, by touching one byte in
+   each page it spans.  The kernel may then access the buffer
+   directly, since a page that is valid stays valid until the
+   process changes its own address space.  Returns true if
+   successful, false if a segfault occurred. */
+bool
+probe_user (const void *ubuf, size_t size, bool write)
+{
+  const uint8_t *p = ubuf;
+  const uint8_t *end = p + size;
+
+  if (!is_user_range (ubuf, size))
+    return false;
+  while (p < end)
+    {
+      uint8_t byte;
+
+      if (!get_user (&byte, p)
+          || (write && !put_user ((uint8_t *) p, byte)))
+        return false;
+      p = (const uint8_t *) pg_round_down (p) + PGSIZE;
+    }
+  return true;
+}
+
+/* If F is a fault taken by one of the functions above, arranges
+   for that function to return failure and returns true.
+   Otherwise, returns false. */
+bool
+uaccess_fixup (struct intr_frame *f)
+{
+  const struct uaccess_fixup *e;
+
+  for (e = _start_uaccess_fixups; e < _end_uaccess_fixups; e++)
+    if (e->insn == (uintptr_t) f->eip)
+      {
+        f->eip = (void *) e->fixup;
+        f->eax = 0;
+        return true;
+      }
+  return false;
+}
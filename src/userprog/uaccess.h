@@ -0,0 +1,19 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct intr_frame;
+
+bool get_user (uint8_t *dst, const uint8_t *usrc);
+bool put_user (uint8_t *udst, uint8_t byte);
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+bool copy_string_from_user (char *dst, const char *usrc, size_t size);
+bool probe_user (const void *ubuf, size_t size, bool write);
+
+bool uaccess_fixup (struct intr_frame *);
+
+#endif /* userprog/uaccess.h */
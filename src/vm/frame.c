@@ -0,0 +1,462 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Frame table.
+
+   Every frame in the user pool that holds a user page has an
+   entry here recording the pages that map it.  When the user
+   pool runs dry, frame_alloc() takes a frame away from its pages
+   using the clock (second chance) algorithm: the hand sweeps the
+   table, clearing the accessed bits of the pages of each frame it
+   passes, and stops at the first frame none of whose pages had
+   been accessed.  Victims are taken in batches of up to
+   SWAP_CLUSTER, so that their modified pages reach swap in one
+   write; frames beyond the one asked for go back to the user
+   pool for the allocations that are sure to follow.
+
+   Read-only pages of an executable are the same in every process
+   running it, so they are shared.  Once a process has read such a
+   page, its frame is entered in the share table under the inode,
+   offset and length of the file data it holds, and other
+   processes map that frame instead of reading their own copy.
+   Similarly, fork() makes the child's pages map the parent's
+   frames, read-only, until one of them writes; see page.c.  A
+   frame is freed when the last page mapping it goes away.
+
+   The frame lock protects the table, the share table, the clock
+   hand and each frame's list of pages.  A page is protected by
+   its own lock, which the evicting thread holds while it writes
+   the page out, so that the owner faulting on that page waits
+   for eviction to finish.  Pinned frames (those being loaded or
+   evicted, or that the kernel is reading or writing on behalf of
+   a process) are skipped by the hand.  A frame may be pinned more
+   than once, e.g. by two processes whose buffers share it. */
+
+static struct list frame_list;          /* All user frames. */
+static struct hash share_table;         /* Frames that may be shared. */
+static struct list_elem *clock_hand;    /* Next frame to consider. */
+static struct lock frame_lock;          /* Protects the above. */
+
+static struct frame *frame_evict (void);
+static size_t frame_choose_victims (struct frame *[], size_t max);
+static bool frame_clear_accessed (struct frame *);
+static bool frame_lock_pages (struct frame *);
+static void frame_unlock_pages (struct frame *);
+static void frame_share (struct frame *);
+static void frame_release (struct frame *);
+static struct frame *clock_advance (void);
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frame_list);
+  hash_init (&share_table, share_hash, share_less, NULL);
+  lock_init (&frame_lock);
+  clock_hand = list_end (&frame_list);
+}
+
+/* Obtains a frame for PAGE, which belongs to the current
+   process, or for no page yet if PAGE is null.  A free frame
+   from the user pool is used if there is one, otherwise one is
+   evicted.  If PAL_ZERO is set in FLAGS, the frame is zeroed.
+   The frame is returned pinned; the caller must frame_unpin() it
+   once the page is mapped.  Returns a null pointer if no frame
+   can be found. */
+struct frame *
+frame_alloc (struct page *page, enum palloc_flags flags)
+{
+  struct frame *f;
+  void *kpage;
+
+  kpage = palloc_get_page (PAL_USER | (flags & PAL_ZERO));
+  if (kpage != NULL)
+    {
+      f = malloc (sizeof *f);
+      if (f == NULL)
+        {
+          palloc_free_page (kpage);
+          return NULL;
+        }
+      f->kpage = kpage;
+      list_init (&f->pages);
+      f->pin_cnt = 1;
+      f->inode = NULL;
+      lock_acquire (&frame_lock);
+      list_push_back (&frame_list, &f->elem);
+      lock_release (&frame_lock);
+    }
+  else
+    {
+      f = frame_evict ();
+      if (f == NULL)
+        return NULL;
+      if (flags & PAL_ZERO)
+        memset (f->kpage, 0, PGSIZE);
+    }
+
+  if (page != NULL)
+    frame_attach (f, page);
+  return f;
+}
+
+/* Keeps F from being evicted until a matching frame_unpin().  The
+   caller must already have F pinned, or hold the lock of one of
+   its pages. */
+void
+frame_pin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  f->pin_cnt++;
+  lock_release (&frame_lock);
+}
+
+/* Undoes one pin of F, making it a candidate for eviction again
+   once no pins remain. */
+void
+frame_unpin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pin_cnt > 0);
+  f->pin_cnt--;
+  lock_release (&frame_lock);
+}
+
+/* Adds PAGE to the pages mapping F.  F must be pinned, or the
+   lock of one of its pages held, so that it is not evicted in the
+   meantime.  The caller must map it. */
+void
+frame_attach (struct frame *f, struct page *page)
+{
+  lock_acquire (&frame_lock);
+  list_push_back (&f->pages, &page->frame_elem);
+  lock_release (&frame_lock);
+}
+
+/* Removes PAGE from the pages mapping F.  The caller must already
+   have unmapped it.  Once no page maps F any more, F is removed
+   from the frame table and its memory returned to the user
+   pool. */
+void
+frame_detach (struct frame *f, struct page *page)
+{
+  bool last;
+
+  lock_acquire (&frame_lock);
+  list_remove (&page->frame_elem);
+  last = list_empty (&f->pages);
+  if (last)
+    frame_release (f);
+  lock_release (&frame_lock);
+
+  if (last)
+    {
+      palloc_free_page (f->kpage);
+      free (f);
+    }
+}
+
+/* Returns true if more than one page maps F. */
+bool
+frame_is_shared (struct frame *f)
+{
+  bool shared;
+
+  lock_acquire (&frame_lock);
+  shared = list_size (&f->pages) > 1;
+  lock_release (&frame_lock);
+  return shared;
+}
+
+/* Looks in the share table for a frame holding READ_BYTES bytes
+   of INODE starting at offset OFS, followed by zeros.  If there is
+   one, adds PAGE to the pages mapping it and returns it; the
+   caller must map it.  PAGE's lock must be held, which keeps the
+   frame from being evicted until it is mapped.  Returns a null
+   pointer if there is no such frame. */
+struct frame *
+frame_share_lookup (struct inode *inode, off_t ofs, uint32_t read_bytes,
+                    struct page *page)
+{
+  struct frame key;
+  struct hash_elem *e;
+  struct frame *f = NULL;
+
+  ASSERT (lock_held_by_current_thread (&page->lock));
+
+  key.inode = inode;
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+
+  lock_acquire (&frame_lock);
+  e = hash_find (&share_table, &key.share_elem);
+  if (e != NULL)
+    {
+      f = hash_entry (e, struct frame, share_elem);
+      list_push_back (&f->pages, &page->frame_elem);
+    }
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Enters F, which has just been filled with READ_BYTES bytes of
+   INODE starting at offset OFS followed by zeros, in the share
+   table.  If another process got there first, F simply stays
+   private. */
+void
+frame_share_add (struct frame *f, struct inode *inode, off_t ofs,
+                 uint32_t read_bytes)
+{
+  ASSERT (f->inode == NULL);
+
+  f->inode = inode;
+  f->ofs = ofs;
+  f->read_bytes = read_bytes;
+
+  lock_acquire (&frame_lock);
+  frame_share (f);
+  lock_release (&frame_lock);
+}
+
+/* Takes frames away from the pages that map them and returns
+   one of them, pinned.  Returns a null pointer if no page can be
+   evicted, e.g. because every candidate is modified and swap is
+   full. */
+static struct frame *
+frame_evict (void)
+{
+  size_t tries;
+
+  lock_acquire (&frame_lock);
+  tries = DIV_ROUND_UP (list_size (&frame_list), SWAP_CLUSTER);
+  lock_release (&frame_lock);
+
+  while (tries-- > 0)
+    {
+      struct frame *victims[SWAP_CLUSTER];
+      struct frame *result = NULL;
+      size_t cnt;
+      size_t i;
+
+      lock_acquire (&frame_lock);
+      cnt = frame_choose_victims (victims, SWAP_CLUSTER);
+      lock_release (&frame_lock);
+      if (cnt == 0)
+        return NULL;
+
+      /* frame_choose_victims() acquired the pages' locks for us. */
+      page_out (victims, cnt);
+
+      lock_acquire (&frame_lock);
+      for (i = 0; i < cnt; i++)
+        {
+          struct frame *f = victims[i];
+          struct page *p = list_entry (list_front (&f->pages),
+                                       struct page, frame_elem);
+
+          if (p->frame != NULL)
+            {
+              /* Could not be written out. */
+              frame_unlock_pages (f);
+              frame_share (f);
+              f->pin_cnt--;
+              continue;
+            }
+
+          while (!list_empty (&f->pages))
+            {
+              p = list_entry (list_pop_front (&f->pages),
+                              struct page, frame_elem);
+              lock_release (&p->lock);
+            }
+          f->inode = NULL;
+          if (result == NULL)
+            result = f;
+          else
+            {
+              frame_release (f);
+              palloc_free_page (f->kpage);
+              free (f);
+            }
+        }
+      lock_release (&frame_lock);
+
+      if (result != NULL)
+        return result;
+    }
+  return NULL;
+}
+
+/* Runs the clock hand until it has found up to MAX unpinned
+   frames none of whose pages have been accessed since the hand
+   last passed them, storing them in VICTIMS[].  Pins each victim,
+   takes it out of the share table and acquires the locks of all
+   its pages.  Gives up after two full sweeps.  Returns the number
+   of victims found.  The frame lock must be held. */
+static size_t
+frame_choose_victims (struct frame *victims[], size_t max)
+{
+  size_t sweep = 2 * list_size (&frame_list);
+  size_t cnt = 0;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  while (cnt < max && sweep-- > 0)
+    {
+      struct frame *f = clock_advance ();
+
+      if (f->pin_cnt > 0 || frame_clear_accessed (f) || !frame_lock_pages (f))
+        continue;
+
+      if (f->inode != NULL)
+        hash_delete (&share_table, &f->share_elem);
+      f->pin_cnt++;
+      victims[cnt++] = f;
+    }
+  return cnt;
+}
+
+/* Clears the accessed bit of each page mapping F.  Returns true
+   if any of them was set. */
+static bool
+frame_clear_accessed (struct frame *f)
+{
+  struct list_elem *e;
+  bool accessed = false;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      if (pagedir_is_accessed (pd, p->upage))
+        {
+          pagedir_set_accessed (pd, p->upage, false);
+          accessed = true;
+        }
+    }
+  return accessed;
+}
+
+/* Tries to acquire the locks of all the pages mapping F without
+   waiting.  Returns true if successful.  Otherwise, some page is
+   busy (possibly being faulted in by this very thread), so none
+   of the locks is left held and false is returned. */
+static bool
+frame_lock_pages (struct frame *f)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+
+      if (lock_held_by_current_thread (&p->lock)
+          || !lock_try_acquire (&p->lock))
+        {
+          while (e != list_begin (&f->pages))
+            {
+              e = list_prev (e);
+              p = list_entry (e, struct page, frame_elem);
+              lock_release (&p->lock);
+            }
+          return false;
+        }
+    }
+  return true;
+}
+
+/* Releases the locks of all the pages mapping F.  The frame lock
+   must be held, so that no page can leave F's list as soon as its
+   lock is released. */
+static void
+frame_unlock_pages (struct frame *f)
+{
+  struct list_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    lock_release (&list_entry (e, struct page, frame_elem)->lock);
+}
+
+/* Inserts F in the share table if it has a key and no other
+   frame with the same key is there already; otherwise makes F
+   private.  The frame lock must be held. */
+static void
+frame_share (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (f->inode != NULL && hash_insert (&share_table, &f->share_elem) != NULL)
+    f->inode = NULL;
+}
+
+/* Removes F from the frame table and the share table.  The frame
+   lock must be held. */
+static void
+frame_release (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (clock_hand == &f->elem)
+    clock_hand = list_next (clock_hand);
+  list_remove (&f->elem);
+  if (f->inode != NULL)
+    hash_delete (&share_table, &f->share_elem);
+}
+
+/* Returns the frame under the clock hand and moves the hand on
+   to the next frame, wrapping around at the end of the table.
+   The frame table must not be empty. */
+static struct frame *
+clock_advance (void)
+{
+  struct frame *f;
+
+  ASSERT (!list_empty (&frame_list));
+
+  if (clock_hand == list_end (&frame_list))
+    clock_hand = list_begin (&frame_list);
+  f = list_entry (clock_hand, struct frame, elem);
+  clock_hand = list_next (clock_hand);
+  return f;
+}
+
+/* Returns a hash value for the shared frame that E refers to. */
+static unsigned
+share_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, share_elem);
+  return hash_bytes (&f->inode, sizeof f->inode) ^ hash_int (f->ofs);
+}
+
+/* Returns true if shared frame A precedes shared frame B. */
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct frame *a = hash_entry (a_, struct frame, share_elem);
+  const struct frame *b = hash_entry (b_, struct frame, share_elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  else if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  else
+    return a->read_bytes < b->read_bytes;
+}
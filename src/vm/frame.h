@@ -0,0 +1,49 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/palloc.h"
+
+struct inode;
+struct page;
+
+/* A physical frame holding a user page.
+
+   Usually a frame backs exactly one page of one process, but a
+   frame holding read-only executable data may be mapped by every
+   process running that executable, and fork() leaves parent and
+   child sharing all their frames until one of them writes.
+   Frames of executable data are entered in the share table under
+   the part of the file they hold. */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address of the frame. */
+    struct list pages;          /* Pages mapping this frame. */
+    unsigned pin_cnt;           /* Never chosen for eviction if > 0. */
+    struct list_elem elem;      /* Element in the frame table. */
+
+    /* Share table key, valid iff INODE is nonnull. */
+    struct inode *inode;        /* File the frame caches. */
+    off_t ofs;                  /* Offset of the data in INODE. */
+    uint32_t read_bytes;        /* Bytes of file data; rest is zero. */
+    struct hash_elem share_elem; /* Element in the share table. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *, enum palloc_flags);
+void frame_pin (struct frame *);
+void frame_unpin (struct frame *);
+void frame_attach (struct frame *, struct page *);
+void frame_detach (struct frame *, struct page *);
+bool frame_is_shared (struct frame *);
+
+struct frame *frame_share_lookup (struct inode *, off_t ofs,
+                                  uint32_t read_bytes, struct page *);
+void frame_share_add (struct frame *, struct inode *, off_t ofs,
+                      uint32_t read_bytes);
+
+#endif /* vm/frame.h */
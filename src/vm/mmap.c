@@ -0,0 +1,148 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* Memory-mapped files.
+
+   mmap_map() does not read anything.  It only adds an entry to
+   the supplemental page table for each page of the file, so the
+   data is faulted in page by page as the process touches it,
+   straight into the frame the process sees.  Modified pages are
+   written back to the file when they are evicted, when the
+   mapping is removed, or when the process exits; pages whose
+   dirty bit is clear are never written.
+
+   Each mapping keeps its own handle on the file, so closing or
+   removing the file does not affect it. */
+
+static struct mapping *mmap_lookup (mapid_t);
+static void mmap_release (struct mapping *);
+
+/* Maps FILE into the current process's address space starting
+   at ADDR.  The caller must hold the process's page table lock
+   and then the file system lock.  Returns
+   the new mapping's identifier, or MAP_FAILED if FILE is empty,
+   ADDR is null or not page-aligned, or the pages the file would
+   occupy overlap pages already in use or the area reserved for
+   the stack. */
+mapid_t
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = process_current ();
+  struct mapping *m;
+  uint8_t *stack_bottom;
+  off_t length;
+  off_t ofs;
+
+  ASSERT (lock_held_by_current_thread (&t->pages_lock));
+  ASSERT (lock_held_by_current_thread (&file_sys_lock));
+
+  length = file_length (file);
+  if (addr == NULL || pg_ofs (addr) != 0 || length == 0)
+    return MAP_FAILED;
+  stack_bottom = (uint8_t *) PHYS_BASE - stack_limit;
+  if ((uint8_t *) addr >= stack_bottom
+      || (size_t) length > (size_t) (stack_bottom - (uint8_t *) addr))
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+  m->file = file_reopen (file);
+  if (m->file == NULL)
+    {
+      free (m);
+      return MAP_FAILED;
+    }
+  m->addr = addr;
+  m->page_cnt = 0;
+
+  for (ofs = 0; ofs < length; ofs += PGSIZE)
+    {
+      void *upage = (uint8_t *) addr + ofs;
+      uint32_t read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+
+      if (page_lookup (upage) != NULL
+          || page_add_mmap (upage, m->file, ofs, read_bytes) == NULL)
+        {
+          mmap_release (m);
+          return MAP_FAILED;
+        }
+      m->page_cnt++;
+    }
+
+  m->mapid = t->mapid_count++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->mapid;
+}
+
+/* Removes the current process's mapping MAPID, writing back any
+   modified pages.  Does nothing if there is no such mapping.  The
+   caller must hold the process's page table lock. */
+void
+mmap_unmap (mapid_t mapid)
+{
+  struct mapping *m = mmap_lookup (mapid);
+
+  if (m != NULL)
+    {
+      list_remove (&m->elem);
+      mmap_release (m);
+    }
+}
+
+/* Removes all of the current process's mappings.  Called when
+   the process exits, while its page table is still intact. */
+void
+mmap_unmap_all (void)
+{
+  struct list *mappings = &process_current ()->mappings;
+
+  while (!list_empty (mappings))
+    mmap_release (list_entry (list_pop_front (mappings),
+                              struct mapping, elem));
+}
+
+/* Returns the current process's mapping MAPID, or a null
+   pointer if there is none. */
+static struct mapping *
+mmap_lookup (mapid_t mapid)
+{
+  struct list *mappings = &process_current ()->mappings;
+  struct list_elem *e;
+
+  for (e = list_begin (mappings); e != list_end (mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->mapid == mapid)
+        return m;
+    }
+  return NULL;
+}
+
+/* Removes M's pages from the page table, closes its file and
+   frees it.  M must not be in a list. */
+static void
+mmap_release (struct mapping *m)
+{
+  bool held = lock_held_by_current_thread (&file_sys_lock);
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove ((uint8_t *) m->addr + i * PGSIZE);
+
+  if (!held)
+    lock_acquire (&file_sys_lock);
+  file_close (m->file);
+  if (!held)
+    lock_release (&file_sys_lock);
+  free (m);
+}
@@ -0,0 +1,27 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <list.h>
+#include <stddef.h>
+
+struct file;
+
+/* Map region identifier. */
+typedef int mapid_t;
+#define MAP_FAILED ((mapid_t) -1)
+
+/* A file mapped into a process's address space. */
+struct mapping
+  {
+    mapid_t mapid;              /* Mapping identifier. */
+    struct file *file;          /* Private handle on the file. */
+    void *addr;                 /* First user page of the mapping. */
+    size_t page_cnt;            /* Number of pages mapped. */
+    struct list_elem elem;      /* Element in thread's `mappings'. */
+  };
+
+mapid_t mmap_map (struct file *, void *addr);
+void mmap_unmap (mapid_t);
+void mmap_unmap_all (void);
+
+#endif /* vm/mmap.h */
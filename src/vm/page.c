@@ -0,0 +1,780 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Supplemental page table.
+
+   Each process keeps a hash table, keyed on user virtual page,
+   describing every page of its address space.  When the process
+   is loaded, load_segment() records where each page of the
+   executable lives instead of reading it, so nothing is read
+   from disk until the process actually touches a page.  The page
+   fault handler then calls page_fault_in() to find the entry,
+   obtain a frame, fill it and map it.
+
+   Frames may later be taken away again by the frame table's
+   eviction code, which calls page_out().  Each entry's lock
+   keeps eviction and fault-in of the same page apart.  A page
+   that has been modified goes to swap on eviction; once it is
+   read back, swap holds no copy, so it is treated as modified
+   from then on.  Pages of memory-mapped files never go to swap:
+   a modified one is written back to its file instead, when it is
+   evicted or unmapped, and a clean one is simply dropped.
+
+   A page that starts out all zeros is not given a frame until it
+   is written.  Until then, reading it maps the shared zero page,
+   a single all-zero frame mapped read-only into every such page,
+   so that large arrays in BSS cost nothing until they are used.
+   The first write faults and is given a private zeroed frame.
+
+   The stack is the one region with no entries up front beyond
+   its first page.  A fault just below the user stack pointer, or
+   anywhere between it and the top of the stack, is taken as the
+   stack growing, and a zero page is added there on the spot, as
+   long as the stack stays within stack_limit bytes. */
+
+/* The shared zero page.  It belongs to the kernel pool, is never
+   modified, and never enters the frame table. */
+static void *zero_kpage;
+
+/* Maximum size of a user stack in bytes.  Set by the -sl
+   command-line option in threads/init.c. */
+size_t stack_limit = STACK_LIMIT_DEFAULT;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+static struct page *page_create (void *upage, bool writable,
+                                 enum page_type);
+static struct page *page_insert (struct page *);
+static struct page *page_find (const void *uaddr, const void *esp);
+static bool page_read_file (struct page *, void *kpage);
+static bool page_write_file (struct page *, bool block);
+static bool page_is_zero (const struct page *);
+static bool page_is_shareable (const struct page *);
+static bool page_map_zero (struct page *);
+static bool page_copy (struct page *, struct thread *parent);
+static bool page_unshare (struct page *);
+static bool page_unmap_frame (struct frame *);
+static void page_remap_frame (struct frame *);
+static void page_detach_frame (struct frame *, size_t slot);
+
+/* Allocates the shared zero page. */
+void
+page_init (void)
+{
+  zero_kpage = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+}
+
+/* Initializes PAGES as an empty supplemental page table.
+   Returns false if memory allocation fails. */
+bool
+page_table_init (struct hash *pages)
+{
+  return hash_init (pages, page_hash, page_less, NULL);
+}
+
+/* Frees every entry in PAGES, along with the frames they occupy,
+   and the table itself.  Must be called by the owning process
+   while its page directory is still in place. */
+void
+page_table_destroy (struct hash *pages)
+{
+  hash_destroy (pages, page_destroy);
+}
+
+/* Adds an entry for UPAGE to the current process's page table,
+   to be filled by reading READ_BYTES bytes from FILE at offset
+   OFS and zeroing the following ZERO_BYTES bytes.  The page may
+   be written iff WRITABLE.  Returns the new entry, or a null
+   pointer if UPAGE is already in the table or memory is short. */
+struct page *
+page_add_file (void *upage, struct file *file, off_t ofs,
+               uint32_t read_bytes, uint32_t zero_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (read_bytes + zero_bytes == PGSIZE);
+
+  p = page_create (upage, writable, PAGE_FILE);
+  if (p == NULL)
+    return NULL;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->zero_bytes = zero_bytes;
+  return page_insert (p);
+}
+
+/* Adds an all-zero page at UPAGE to the current process's page
+   table, writable iff WRITABLE.  Returns the new entry, or a
+   null pointer if UPAGE is already in the table or memory is
+   short. */
+struct page *
+page_add_zero (void *upage, bool writable)
+{
+  struct page *p = page_create (upage, writable, PAGE_ZERO);
+  return p != NULL ? page_insert (p) : NULL;
+}
+
+/* Adds a page at UPAGE of a memory-mapped file to the current
+   process's page table.  The page holds READ_BYTES bytes of FILE
+   starting at offset OFS, followed by zeros, and modifications
+   to those bytes are written back to FILE.  Returns the new
+   entry, or a null pointer if UPAGE is already in the table or
+   memory is short. */
+struct page *
+page_add_mmap (void *upage, struct file *file, off_t ofs,
+               uint32_t read_bytes)
+{
+  struct page *p;
+
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = page_create (upage, true, PAGE_MMAP);
+  if (p == NULL)
+    return NULL;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->zero_bytes = PGSIZE - read_bytes;
+  return page_insert (p);
+}
+
+/* Removes UPAGE from the current process's page table, writing
+   it back first if it is a modified page of a mapped file.  Does
+   nothing if UPAGE is not in the table. */
+void
+page_remove (void *upage)
+{
+  struct page *p = page_lookup (upage);
+
+  if (p != NULL)
+    {
+      hash_delete (&process_current ()->pages, &p->hash_elem);
+      page_destroy (&p->hash_elem, NULL);
+    }
+}
+
+/* Returns the current process's page table entry for the page
+   containing UADDR, or a null pointer if there is none. */
+struct page *
+page_lookup (const void *uaddr)
+{
+  struct page key;
+  struct hash_elem *e;
+
+  key.upage = pg_round_down (uaddr);
+  e = hash_find (&process_current ()->pages, &key.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Obtains a frame for P, fills it with the page's contents and
+   maps it into the current process's page directory.  A
+   read-only page of the executable maps the frame of another
+   process running the same executable if there is one, in which
+   case P's lock must be held.  Returns true if successful, false
+   on allocation or read failure. */
+bool
+page_load (struct page *p)
+{
+  struct thread *t = thread_current ();
+  bool shareable = page_is_shareable (p);
+  struct frame *f;
+
+  ASSERT (p->frame == NULL);
+
+  if (shareable)
+    {
+      f = frame_share_lookup (file_get_inode (p->file), p->ofs,
+                              p->read_bytes, p);
+      if (f != NULL)
+        {
+          if (!pagedir_set_page (t->pagedir, p->upage, f->kpage, false))
+            {
+              frame_detach (f, p);
+              return false;
+            }
+          p->frame = f;
+          return true;
+        }
+    }
+
+  f = frame_alloc (p, p->type == PAGE_ZERO && p->swap_slot == SWAP_NONE
+                      ? PAL_ZERO : 0);
+  if (f == NULL)
+    return false;
+
+  if (p->swap_slot != SWAP_NONE)
+    swap_in (p->swap_slot, f->kpage);
+  else if (p->type != PAGE_ZERO && !page_read_file (p, f->kpage))
+    {
+      frame_detach (f, p);
+      return false;
+    }
+
+  /* Replace the shared zero page if it is mapped here. */
+  pagedir_clear_page (t->pagedir, p->upage);
+  if (!pagedir_set_page (t->pagedir, p->upage, f->kpage, p->writable))
+    {
+      frame_detach (f, p);
+      return false;
+    }
+  if (p->swap_slot != SWAP_NONE)
+    {
+      /* Swap no longer holds a copy, so the page must be written
+         out again if it is evicted. */
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_NONE;
+      pagedir_set_dirty (t->pagedir, p->upage, true);
+    }
+  if (shareable)
+    frame_share_add (f, file_get_inode (p->file), p->ofs, p->read_bytes);
+  p->frame = f;
+  frame_unpin (f);
+  return true;
+}
+
+/* Returns true if an access to UADDR by a process whose stack
+   pointer is ESP should be treated as a stack access.  The 80x86
+   PUSHA instruction faults 32 bytes below the stack pointer
+   before it is decremented, so that much slack is allowed.  A
+   null ESP means the stack pointer is not known. */
+bool
+page_is_stack_access (const void *uaddr, const void *esp)
+{
+  return (esp != NULL && is_user_vaddr (uaddr)
+          && (const uint8_t *) uaddr >= (const uint8_t *) PHYS_BASE
+                                        - stack_limit
+          && (const uint8_t *) uaddr + 32 >= (const uint8_t *) esp);
+}
+
+/* Handles a page fault at FAULT_ADDR in the current process,
+   whose user stack pointer is ESP.  WRITE is true if the faulting
+   access was a write.  Brings in the page if it is not resident,
+   growing the stack if FAULT_ADDR is not in the table but looks
+   like a stack access.  Reading a page that is still all zeros
+   maps the shared zero page.  A write to a writable page that is
+   mapped read-only because it is shared copy-on-write gets a
+   private copy of the page.  Faults by the threads of one process
+   are handled one at a time, under its page table lock.  Returns
+   true if the faulting access may be retried, false if it is not
+   allowed. */
+bool
+page_fault_in (const void *fault_addr, const void *esp, bool write)
+{
+  struct lock *pages_lock = &process_current ()->pages_lock;
+  struct page *p;
+  bool success;
+
+  if (thread_current ()->pagedir == NULL)
+    return false;
+
+  lock_acquire (pages_lock);
+  p = page_find (fault_addr, esp);
+  if (p == NULL || (write && !p->writable))
+    {
+      lock_release (pages_lock);
+      return false;
+    }
+
+  /* If the page is resident by the time we get the lock, it was
+     being evicted and the eviction was abandoned, or it is shared
+     copy-on-write. */
+  lock_acquire (&p->lock);
+  if (!write && page_is_zero (p))
+    success = page_map_zero (p);
+  else if (p->frame == NULL)
+    success = page_load (p);
+  else if (write)
+    success = page_unshare (p);
+  else
+    success = true;
+  lock_release (&p->lock);
+  lock_release (pages_lock);
+  return success;
+}
+
+/* Brings in every page spanned by the SIZE bytes at user address
+   UADDR, as page_fault_in() would for a fault by a process whose
+   stack pointer is ESP, and pins its frame, so that the kernel
+   may read the buffer, or if WRITE is true write it, directly,
+   without faulting, for instance by having the disk driver
+   transfer sectors straight into it.  Unlike a fault, reading a
+   page that is still all zeros gives it a private frame, since
+   the shared zero page is never pinned.  Returns true if
+   successful; the caller must then call page_unpin() once it is
+   done with the buffer.  Returns false, with nothing pinned, if
+   some byte may not be accessed or memory is short. */
+bool
+page_pin (const void *uaddr, size_t size, const void *esp, bool write)
+{
+  struct lock *pages_lock = &process_current ()->pages_lock;
+  const uint8_t *start = pg_round_down (uaddr);
+  const uint8_t *upage;
+  const uint8_t *end = (const uint8_t *) uaddr + size;
+
+  if (!is_user_vaddr (uaddr)
+      || size > (uintptr_t) PHYS_BASE - (uintptr_t) uaddr
+      || thread_current ()->pagedir == NULL)
+    return false;
+
+  lock_acquire (pages_lock);
+  for (upage = start; upage < end; upage += PGSIZE)
+    {
+      struct page *p = page_find (upage, esp);
+      bool success;
+
+      if (p == NULL || (write && !p->writable))
+        success = false;
+      else
+        {
+          lock_acquire (&p->lock);
+          if (p->frame == NULL)
+            success = page_load (p);
+          else if (write)
+            success = page_unshare (p);
+          else
+            success = true;
+          if (success)
+            frame_pin (p->frame);
+          lock_release (&p->lock);
+        }
+
+      if (!success)
+        {
+          lock_release (pages_lock);
+          page_unpin (start, upage - start);
+          return false;
+        }
+    }
+  lock_release (pages_lock);
+  return true;
+}
+
+/* Unpins the frames of the pages spanned by the SIZE bytes at
+   UADDR, which must have been pinned by page_pin(). */
+void
+page_unpin (const void *uaddr, size_t size)
+{
+  struct lock *pages_lock = &process_current ()->pages_lock;
+  const uint8_t *upage = pg_round_down (uaddr);
+  const uint8_t *end = (const uint8_t *) uaddr + size;
+
+  /* A pinned page keeps its frame, so P->frame is stable without
+     P's lock. */
+  lock_acquire (pages_lock);
+  for (; upage < end; upage += PGSIZE)
+    frame_unpin (page_lookup (upage)->frame);
+  lock_release (pages_lock);
+}
+
+/* Returns the current process's page table entry for the page
+   containing UADDR.  If there is none but UADDR looks like an
+   access to the stack of a process whose stack pointer is ESP,
+   grows the stack to include it.  Returns a null pointer if
+   UADDR is not part of the address space. */
+static struct page *
+page_find (const void *uaddr, const void *esp)
+{
+  struct page *p = page_lookup (uaddr);
+
+  if (p == NULL && page_is_stack_access (uaddr, esp))
+    p = page_add_zero (pg_round_down (uaddr), true);
+  return p;
+}
+
+/* Adds copies of the entries of PARENT's page table, except those
+   of mapped files, to the current process's page table, for
+   fork().  PARENT is the leader of the forking process, whose
+   page table lock is held for the duration.  Resident
+   pages are not copied: the child's page maps the parent's frame,
+   and both mappings are made read-only until one of the processes
+   writes to the page.  Returns true if successful, false if
+   memory is short. */
+bool
+page_table_copy (struct thread *parent)
+{
+  struct hash_iterator i;
+  bool success = true;
+
+  lock_acquire (&parent->pages_lock);
+  hash_first (&i, &parent->pages);
+  while (success && hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+
+      if (p->type != PAGE_MMAP && !page_copy (p, parent))
+        success = false;
+    }
+  lock_release (&parent->pages_lock);
+  return success;
+}
+
+/* Takes the CNT frames in FRAMES[] away from the pages that map
+   them, on behalf of the frame table.  Each frame must be pinned
+   and the locks of all its pages held.  Every page is unmapped
+   first so that its owner cannot modify it behind our back.
+   Frames that no page has modified are then simply dropped, since
+   they can be rebuilt from their file or from zeros.  Modified
+   pages of mapped files are written back to their files, and
+   other modified frames are written to swap together.  A frame
+   that cannot be written out is mapped again.  On return, a frame
+   has been evicted iff its pages' `frame' members are null. */
+void
+page_out (struct frame *frames[], size_t cnt)
+{
+  struct frame *dirty[SWAP_CLUSTER];
+  void *kpages[SWAP_CLUSTER];
+  size_t slots[SWAP_CLUSTER];
+  size_t dirty_cnt = 0;
+  size_t i;
+
+  ASSERT (cnt <= SWAP_CLUSTER);
+
+  for (i = 0; i < cnt; i++)
+    {
+      struct frame *f = frames[i];
+      struct page *p = list_entry (list_front (&f->pages),
+                                   struct page, frame_elem);
+
+      ASSERT (f->pin_cnt > 0);
+
+      if (!page_unmap_frame (f))
+        page_detach_frame (f, SWAP_NONE);
+      else if (p->type != PAGE_MMAP)
+        {
+          dirty[dirty_cnt] = f;
+          kpages[dirty_cnt++] = f->kpage;
+        }
+      else if (page_write_file (p, false))
+        page_detach_frame (f, SWAP_NONE);
+      else
+        page_remap_frame (f);
+    }
+
+  if (dirty_cnt == 0)
+    return;
+  if (swap_out (kpages, dirty_cnt, slots))
+    for (i = 0; i < dirty_cnt; i++)
+      page_detach_frame (dirty[i], slots[i]);
+  else
+    for (i = 0; i < dirty_cnt; i++)
+      page_remap_frame (dirty[i]);
+}
+
+/* Returns true if P has no frame and is all zeros, so that it
+   can be backed by the shared zero page until it is written. */
+static bool
+page_is_zero (const struct page *p)
+{
+  return p->frame == NULL && p->type == PAGE_ZERO
+         && p->swap_slot == SWAP_NONE;
+}
+
+/* Maps the shared zero page, read-only, at P's address. */
+static bool
+page_map_zero (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+
+  pagedir_clear_page (pd, p->upage);
+  return pagedir_set_page (pd, p->upage, zero_kpage, false);
+}
+
+/* Returns true if P may share its frame with the same page in
+   other processes: it is read-only data from the executable,
+   which cannot change while the executable is running. */
+static bool
+page_is_shareable (const struct page *p)
+{
+  return p->type == PAGE_FILE && !p->writable;
+}
+
+/* Adds a copy of PARENT's page P to the current process's page
+   table, sharing P's frame if it has one.  Returns true if
+   successful, false if memory is short. */
+static bool
+page_copy (struct page *p, struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct page *c;
+  bool success = true;
+
+  c = page_create (p->upage, p->writable, p->type);
+  if (c == NULL)
+    return false;
+  c->file = p->file == parent->executable ? t->executable : p->file;
+  c->ofs = p->ofs;
+  c->read_bytes = p->read_bytes;
+  c->zero_bytes = p->zero_bytes;
+  if (page_insert (c) == NULL)
+    return false;
+
+  lock_acquire (&p->lock);
+  if (p->frame != NULL)
+    {
+      uint32_t *ppd = parent->pagedir;
+
+      /* The child inherits the dirty bit, since no one will write
+         to the frame again while it is shared. */
+      if (p->writable)
+        pagedir_set_writable (ppd, p->upage, false);
+      frame_attach (p->frame, c);
+      c->frame = p->frame;
+      success = pagedir_set_page (t->pagedir, c->upage, c->frame->kpage,
+                                  false);
+      if (success && pagedir_is_dirty (ppd, p->upage))
+        pagedir_set_dirty (t->pagedir, c->upage, true);
+    }
+  else if (p->swap_slot != SWAP_NONE)
+    c->swap_slot = swap_dup (p->swap_slot);
+  lock_release (&p->lock);
+  return success;
+}
+
+/* Makes P, which is writable and resident, writable in its
+   owner's page directory, giving it a private copy of its frame
+   first if the frame is shared.  P's lock must be held, which also
+   keeps the shared frame from being evicted while it is copied.
+   Returns true if successful, false if no frame is available. */
+static bool
+page_unshare (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+  struct frame *shared = p->frame;
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&p->lock));
+  ASSERT (p->writable);
+
+  if (!frame_is_shared (shared))
+    {
+      pagedir_set_writable (pd, p->upage, true);
+      return true;
+    }
+
+  f = frame_alloc (NULL, 0);
+  if (f == NULL)
+    return false;
+  memcpy (f->kpage, shared->kpage, PGSIZE);
+
+  pagedir_clear_page (pd, p->upage);
+  frame_detach (shared, p);
+  frame_attach (f, p);
+  p->frame = f;
+
+  /* The page table for UPAGE already exists, so this cannot
+     fail. */
+  if (!pagedir_set_page (pd, p->upage, f->kpage, true))
+    NOT_REACHED ();
+  pagedir_set_dirty (pd, p->upage, true);
+  frame_unpin (f);
+  return true;
+}
+
+/* Unmaps every page mapping F.  Returns true if any of them had
+   been modified. */
+static bool
+page_unmap_frame (struct frame *f)
+{
+  struct list_elem *e;
+  bool dirty = false;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      ASSERT (lock_held_by_current_thread (&p->lock));
+
+      pagedir_clear_page (pd, p->upage);
+      if (pagedir_is_dirty (pd, p->upage))
+        dirty = true;
+    }
+  return dirty;
+}
+
+/* Maps every page of F again after an eviction that failed, and
+   marks them modified so that the next eviction tries again.  A
+   frame that is still shared stays read-only. */
+static void
+page_remap_frame (struct frame *f)
+{
+  bool shared = list_size (&f->pages) > 1;
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      pagedir_set_page (pd, p->upage, f->kpage, p->writable && !shared);
+      pagedir_set_dirty (pd, p->upage, true);
+    }
+}
+
+/* Records that the pages of F no longer occupy it, their contents
+   having been written to swap slot SLOT, or being recoverable from
+   their original source if SLOT is SWAP_NONE.  Pages still shared
+   copy-on-write share the slot too. */
+static void
+page_detach_frame (struct frame *f, size_t slot)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+
+      p->frame = NULL;
+      if (slot != SWAP_NONE)
+        p->swap_slot = e == list_begin (&f->pages) ? slot : swap_dup (slot);
+    }
+}
+
+/* Reads the file-backed part of P into KPAGE and zeroes the
+   rest.  Page faults may be taken while the file system lock is
+   already held (e.g. read() into a buffer that has not been
+   touched yet), so only acquire the lock if we don't own it. */
+static bool
+page_read_file (struct page *p, void *kpage)
+{
+  bool held = lock_held_by_current_thread (&file_sys_lock);
+  off_t read;
+
+  if (!held)
+    lock_acquire (&file_sys_lock);
+  read = file_read_at (p->file, kpage, p->read_bytes, p->ofs);
+  if (!held)
+    lock_release (&file_sys_lock);
+
+  if (read != (off_t) p->read_bytes)
+    return false;
+  memset ((uint8_t *) kpage + p->read_bytes, 0, p->zero_bytes);
+  return true;
+}
+
+/* Writes the file-backed part of P's frame back to its file.
+   The caller may already hold the file system lock.  If it does
+   not and BLOCK is false, gives up rather than wait for the lock:
+   eviction holds the page's lock, and the lock's holder may be
+   the page's owner faulting on this very page.  Returns true if
+   the page was written. */
+static bool
+page_write_file (struct page *p, bool block)
+{
+  bool held = lock_held_by_current_thread (&file_sys_lock);
+
+  if (!held)
+    {
+      if (block)
+        lock_acquire (&file_sys_lock);
+      else if (!lock_try_acquire (&file_sys_lock))
+        return false;
+    }
+  file_write_at (p->file, p->frame->kpage, p->read_bytes, p->ofs);
+  if (!held)
+    lock_release (&file_sys_lock);
+  return true;
+}
+
+/* Allocates a page table entry for UPAGE with the given
+   WRITABLE flag and TYPE, not yet added to any table. */
+static struct page *
+page_create (void *upage, bool writable, enum page_type type)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->owner = process_current ();
+  p->frame = NULL;
+  lock_init (&p->lock);
+  p->writable = writable;
+  p->type = type;
+  p->file = NULL;
+  p->ofs = 0;
+  p->read_bytes = 0;
+  p->zero_bytes = PGSIZE;
+  p->swap_slot = SWAP_NONE;
+  return p;
+}
+
+/* Inserts P into the current process's page table.  Returns P,
+   or frees it and returns a null pointer if its page is already
+   present. */
+static struct page *
+page_insert (struct page *p)
+{
+  if (hash_insert (&process_current ()->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+  return a->upage < b->upage;
+}
+
+/* Unmaps the page that E refers to, writing it back if it is a
+   modified page of a mapped file, releases its frame, and frees
+   the page table entry. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+  uint32_t *pd = thread_current ()->pagedir;
+
+  lock_acquire (&p->lock);
+
+  /* Unmap even a page with no frame, since the shared zero page
+     may be mapped there and must not be freed along with the page
+     directory.  Clearing the mapping leaves the dirty bit alone. */
+  pagedir_clear_page (pd, p->upage);
+  if (p->frame != NULL)
+    {
+      if (p->type == PAGE_MMAP && pagedir_is_dirty (pd, p->upage))
+        page_write_file (p, true);
+      frame_detach (p->frame, p);
+    }
+  if (p->swap_slot != SWAP_NONE)
+    swap_free (p->swap_slot);
+  lock_release (&p->lock);
+  free (p);
+}
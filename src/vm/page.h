@@ -0,0 +1,74 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+/* Default maximum size of a user stack, in bytes. */
+#define STACK_LIMIT_DEFAULT (8 * 1024 * 1024)
+extern size_t stack_limit;
+
+/* Where the initial contents of a page come from. */
+enum page_type
+  {
+    PAGE_FILE,                  /* Read from a file, zero the rest. */
+    PAGE_ZERO,                  /* All zeros. */
+    PAGE_MMAP                   /* Memory-mapped file: read from it
+                                   and written back to it. */
+  };
+
+/* Supplemental page table entry.
+
+   There is one of these for every user virtual page that a
+   process may legally access, whether or not the page currently
+   has a frame.  The page directory only knows about resident
+   pages; this table remembers how to bring in the others. */
+struct page
+  {
+    void *upage;                /* User virtual address, page aligned. */
+    struct thread *owner;       /* Process whose page this is. */
+    struct frame *frame;        /* Frame holding the page, or null. */
+    struct list_elem frame_elem; /* Element in frame's `pages'. */
+    struct lock lock;           /* Serializes loading and eviction. */
+    bool writable;              /* True if the process may write it. */
+    enum page_type type;        /* Source of the page's contents. */
+
+    /* PAGE_FILE and PAGE_MMAP only. */
+    struct file *file;          /* File to read from. */
+    off_t ofs;                  /* Offset of the data in FILE. */
+    uint32_t read_bytes;        /* Bytes to read from FILE. */
+    uint32_t zero_bytes;        /* Bytes to zero after READ_BYTES. */
+
+    size_t swap_slot;           /* Swap slot holding the page, or
+                                   SWAP_NONE. */
+
+    struct hash_elem hash_elem; /* Element in thread's `pages'. */
+  };
+
+void page_init (void);
+bool page_table_init (struct hash *);
+void page_table_destroy (struct hash *);
+
+struct page *page_add_file (void *upage, struct file *, off_t ofs,
+                            uint32_t read_bytes, uint32_t zero_bytes,
+                            bool writable);
+struct page *page_add_zero (void *upage, bool writable);
+struct page *page_add_mmap (void *upage, struct file *, off_t ofs,
+                            uint32_t read_bytes);
+void page_remove (void *upage);
+struct page *page_lookup (const void *uaddr);
+
+bool page_load (struct page *);
+bool page_is_stack_access (const void *uaddr, const void *esp);
+bool page_fault_in (const void *fault_addr, const void *esp, bool write);
+bool page_pin (const void *uaddr, size_t size, const void *esp, bool write);
+void page_unpin (const void *uaddr, size_t size);
+bool page_table_copy (struct thread *parent);
+void page_out (struct frame *frames[], size_t cnt);
+
+#endif /* vm/page.h */
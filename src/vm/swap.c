@@ -0,0 +1,186 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap space.
+
+   The swap block device is divided into page-sized slots, each
+   BLOCK_SECTOR_SIZE-byte sector of a page going to consecutive
+   sectors of its slot.  A bitmap records which slots are in use.
+
+   The frame table evicts pages in batches of up to SWAP_CLUSTER.
+   swap_out() tries to give such a batch one contiguous run of
+   slots, so that the whole batch reaches the disk as a single
+   multi-sector write.  Only when the swap space is too
+   fragmented for that are the pages scattered over whatever
+   slots are free.
+
+   A page shared copy-on-write between processes that fork()ed
+   is written out once and its slot shared by all of them, so
+   each slot has a reference count.  The slot is free once every
+   process has read the page back or exited. */
+
+/* Number of sectors in a swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block *swap_device;       /* Swap device, or null. */
+static struct bitmap *used_slots;       /* Slots in use. */
+static uint16_t *slot_refs;             /* References to each slot. */
+static struct lock swap_lock;           /* Protects the above and stats. */
+
+/* Statistics. */
+static size_t slots_in_use;             /* # of slots holding a page. */
+static size_t peak_slots_in_use;        /* Largest value of the above. */
+static unsigned long long page_out_cnt; /* # of pages written. */
+static unsigned long long write_cnt;    /* # of write requests. */
+static unsigned long long page_in_cnt;  /* # of pages read. */
+
+/* Initializes the swap space on the BLOCK_SWAP device.  Without
+   one, swap_out() always fails, so modified pages simply stay in
+   memory. */
+void
+swap_init (void)
+{
+  lock_init (&swap_lock);
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device == NULL)
+    return;
+
+  used_slots = bitmap_create (block_size (swap_device) / SECTORS_PER_SLOT);
+  if (used_slots == NULL)
+    PANIC ("swap: bitmap creation failed");
+  slot_refs = calloc (bitmap_size (used_slots), sizeof *slot_refs);
+  if (slot_refs == NULL)
+    PANIC ("swap: reference count allocation failed");
+}
+
+/* Writes the CNT pages at KPAGES[] to swap and stores the slot
+   that each went to in the corresponding element of SLOTS[].
+   Pages that landed in consecutive slots are written with a
+   single request.  Returns true if successful, false if swap
+   does not have room for all of the pages, in which case none of
+   them is written. */
+bool
+swap_out (void *const kpages[], size_t cnt, size_t slots[])
+{
+  const void *buffers[SWAP_CLUSTER * SECTORS_PER_SLOT];
+  size_t first;
+  size_t i;
+
+  ASSERT (cnt <= SWAP_CLUSTER);
+
+  if (cnt == 0)
+    return true;
+  if (used_slots == NULL)
+    return false;
+
+  /* Reserve slots, preferably one contiguous run. */
+  lock_acquire (&swap_lock);
+  first = bitmap_scan_and_flip (used_slots, 0, cnt, false);
+  if (first != BITMAP_ERROR)
+    for (i = 0; i < cnt; i++)
+      slots[i] = first + i;
+  else
+    for (i = 0; i < cnt; i++)
+      {
+        slots[i] = bitmap_scan_and_flip (used_slots, 0, 1, false);
+        if (slots[i] == BITMAP_ERROR)
+          {
+            while (i-- > 0)
+              bitmap_reset (used_slots, slots[i]);
+            lock_release (&swap_lock);
+            return false;
+          }
+      }
+  for (i = 0; i < cnt; i++)
+    slot_refs[slots[i]] = 1;
+  slots_in_use += cnt;
+  if (slots_in_use > peak_slots_in_use)
+    peak_slots_in_use = slots_in_use;
+  lock_release (&swap_lock);
+
+  /* Write each run of consecutive slots with one request. */
+  for (i = 0; i < cnt; )
+    {
+      size_t run = 1;
+      size_t j, k;
+
+      while (i + run < cnt && slots[i + run] == slots[i] + run)
+        run++;
+      for (j = 0; j < run; j++)
+        for (k = 0; k < SECTORS_PER_SLOT; k++)
+          buffers[j * SECTORS_PER_SLOT + k]
+            = (const uint8_t *) kpages[i + j] + k * BLOCK_SECTOR_SIZE;
+      block_write_multiple (swap_device, slots[i] * SECTORS_PER_SLOT,
+                            run * SECTORS_PER_SLOT, buffers);
+
+      lock_acquire (&swap_lock);
+      page_out_cnt += run;
+      write_cnt++;
+      lock_release (&swap_lock);
+      i += run;
+    }
+  return true;
+}
+
+/* Reads the page in SLOT into KPAGE.  The slot stays allocated
+   until the caller frees it with swap_free(). */
+void
+swap_in (size_t slot, void *kpage)
+{
+  size_t i;
+
+  for (i = 0; i < SECTORS_PER_SLOT; i++)
+    block_read (swap_device, slot * SECTORS_PER_SLOT + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+
+  lock_acquire (&swap_lock);
+  page_in_cnt++;
+  lock_release (&swap_lock);
+}
+
+/* Adds a reference to SLOT, for a process that now shares the
+   page in it, and returns SLOT. */
+size_t
+swap_dup (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  ASSERT (slot_refs[slot] < UINT16_MAX);
+  slot_refs[slot]++;
+  lock_release (&swap_lock);
+  return slot;
+}
+
+/* Drops a reference to SLOT, either because its page has been
+   read back or because a process that shared it has exited.  The
+   slot is freed with its last reference. */
+void
+swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  if (--slot_refs[slot] == 0)
+    {
+      bitmap_reset (used_slots, slot);
+      slots_in_use--;
+    }
+  lock_release (&swap_lock);
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void)
+{
+  if (used_slots == NULL)
+    return;
+  printf ("Swap: %zu of %zu slots in use (peak %zu), "
+          "%llu pages out in %llu writes, %llu pages in\n",
+          slots_in_use, bitmap_size (used_slots), peak_slots_in_use,
+          page_out_cnt, write_cnt, page_in_cnt);
+}
@@ -0,0 +1,21 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A page that is not in swap. */
+#define SWAP_NONE SIZE_MAX
+
+/* Most pages written to swap by a single swap_out() call. */
+#define SWAP_CLUSTER 8
+
+void swap_init (void);
+bool swap_out (void *const kpages[], size_t cnt, size_t slots[]);
+void swap_in (size_t slot, void *kpage);
+size_t swap_dup (size_t slot);
+void swap_free (size_t slot);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */